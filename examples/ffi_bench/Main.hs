@@ -0,0 +1,70 @@
+--
+-- Running the benchmark (the number of calls per convention is optional):
+-- $ cabal run -- 1000000
+--
+-- No office process is needed: the call is made in-process, on the service
+-- manager of the bootstrap context.
+--
+{-# LANGUAGE InterruptibleFFI #-}
+module Main where
+
+import Com.Sun.Star.Container.XElementAccess
+import Com.Sun.Star.Lang.XMultiComponentFactory
+import Com.Sun.Star.Uno.XComponentContext
+import UNO
+
+import Control.Monad (unless)
+import Data.Time.Clock (diffUTCTime, getCurrentTime)
+import Foreign
+import System.Environment (getArgs)
+import Text.Printf (printf)
+
+main :: IO ()
+main = do
+  args <- getArgs
+  let n = case args of
+            (a : _) -> read a
+            []      -> 1000000 :: Int
+  xContext <- mkReference . castPtr =<< unoBootstrap
+                :: IO (Reference XComponentContext)
+  xServiceManager <- getServiceManager xContext
+  xElementAccess <- queryInterface xServiceManager
+                      :: IO (Reference XElementAccess)
+  -- the generated import, once, to check the call works at all
+  _ <- hasElements xElementAccess
+  withReference xElementAccess $ \ pIface ->
+    mapM_ (time n pIface)
+      [ ("safe", cHasElementsSafe)
+      , ("unsafe", cHasElementsUnsafe)
+      , ("interruptible", cHasElementsInterruptible)
+      ]
+
+time :: Int -> Ptr XElementAccess
+     -> (String, Ptr XElementAccess -> Ptr AnyPtr -> IO Bool) -> IO ()
+time n pIface (name, call) =
+  allocaBytes anyStructSize $ \ pException ->
+    with pException $ \ exceptionPtr -> do
+      let loop 0 = return ()
+          loop k = do
+            -- the exception pointer is cleared by every successful call
+            poke exceptionPtr pException
+            b <- call pIface exceptionPtr
+            throwIfUnoException =<< peek exceptionPtr
+            unless b $ error "the service manager has no elements"
+            loop (k - 1 :: Int)
+      start <- getCurrentTime
+      loop n
+      end <- getCurrentTime
+      let seconds = realToFrac (diffUTCTime end start) :: Double
+      printf "%-13s %8.1f ns/call\n" name (seconds * 1e9 / fromIntegral n)
+
+-- *Foreign imports of the generated stub
+
+foreign import ccall safe "hsuno_com_sun_star_container_XElementAccess_hasElements"
+  cHasElementsSafe :: Ptr XElementAccess -> Ptr AnyPtr -> IO Bool
+
+foreign import ccall unsafe "hsuno_com_sun_star_container_XElementAccess_hasElements"
+  cHasElementsUnsafe :: Ptr XElementAccess -> Ptr AnyPtr -> IO Bool
+
+foreign import ccall interruptible "hsuno_com_sun_star_container_XElementAccess_hasElements"
+  cHasElementsInterruptible :: Ptr XElementAccess -> Ptr AnyPtr -> IO Bool
@@ -13,8 +13,12 @@ main :: IO ()
 main = do
   xContext <- mkReference . castPtr =<< unoBootstrap :: IO (Reference XComponentContext)
   tME <- theMacroExpanderGet xContext
-  outText <- expandMacros tME inText
-  putStrLn (unpack outText)
+  -- the expanded string is only copied if it differs from the input
+  outRef <- expandMacros' tME inText
+  unchanged <- uStringRefEqualsText outRef inText
+  if unchanged
+    then putStrLn "no macros expanded"
+    else putStrLn . unpack =<< uStringRefToText outRef
 
 inText :: Text
 inText = "test: $UNO_TYPES :test"
@@ -27,6 +27,8 @@ import Com.Sun.Star.Text.XTextCursor
 import Com.Sun.Star.Text.XTextDocument
 import Com.Sun.Star.Text.XTextRange (getEnd, setString)
 import Com.Sun.Star.Text.XTextTable
+import Com.Sun.Star.Text.TextTable
+import Com.Sun.Star.Text.TextTableRow
 
 main :: IO ()
 main = do
@@ -83,14 +85,16 @@ insertTable xTextDocument = do
   xTextContent <- queryInterface xTextTable
   xTextRange <- getEnd xTextCursor
   insertTextContent xText xTextRange xTextContent False
-  -- get XPropertySet interfaces for the first row and the table
-  rRowProperties <- fromAnyIO =<< (`getByIndex` 0) =<< queryInterface =<< getRows xTextTable
-  rTableProperties <- queryInterface xTextTable
+  -- get the properties of the first row and the table
+  rRow <- fromAnyIO =<< (`getByIndex` 0) =<< queryInterface =<< getRows xTextTable
+            :: IO (Reference XPropertySet)
+  tableProperties <- textTableProperties xTextTable
   -- set the back color
-  setPropertyValue rTableProperties "BackTransparent" (toAny False)
-  setPropertyValue rTableProperties "BackColor" (toAny (13421823 :: Int32))
-  setPropertyValue rRowProperties "BackTransparent" (toAny False)
-  setPropertyValue rRowProperties "BackColor" (toAny (6710932 :: Int32))
+  textTableSetBackTransparent tableProperties False
+  textTableSetBackColor tableProperties 13421823
+  withPropertyBatch rRow $ \ row -> do
+    batchSetProperty row "BackTransparent" False
+    batchSetProperty row "BackColor" (6710932 :: Int32)
   -- insert table header
   insertIntoCell xTextTable "A1" "First Column"
   insertIntoCell xTextTable "B1" "Second Column"
@@ -1,17 +1,33 @@
 module UNO
-  ( module UNO.Any
+  ( module UNO.Accounting
+  , module UNO.Any
   , module UNO.Binary
+  , module UNO.Exception
+  , module UNO.Executor
+  , module UNO.Invoke
+  , module UNO.Property
   , module UNO.Reference
+  , module UNO.Scope
+  , module UNO.Sequence
   , module UNO.Service
   , module UNO.Singleton
+  , module UNO.Stream
   , module UNO.Text
   , module UNO.Types
   ) where
 
+import UNO.Accounting
 import UNO.Any
 import UNO.Binary hiding (Any,queryInterface)
+import UNO.Exception
+import UNO.Executor
+import UNO.Invoke
+import UNO.Property
 import UNO.Reference
+import UNO.Scope
+import UNO.Sequence
 import UNO.Service
 import UNO.Singleton
+import UNO.Stream
 import UNO.Text
 import UNO.Types
@@ -0,0 +1,172 @@
+#include "Accounting.hxx"
+
+#include "osl/mutex.hxx"
+#include "rtl/ustring.hxx"
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+char const * const counterNames [HSUNO_COUNTERS] = {
+    "interfaces acquired",
+    "interfaces released",
+    "OUStrings created",
+    "OUStrings freed",
+    "rtl_uStrings created",
+    "rtl_uStrings freed",
+    "Anys constructed",
+    "Anys destructed",
+    "Anys allocated",
+    "Anys freed",
+    "sequences acquired",
+    "sequences released"
+};
+
+std::atomic<sal_Int64> counters [HSUNO_COUNTERS];
+
+std::atomic<bool> tracking (false);
+
+struct InterfaceCount {
+    sal_Int64 acquired;
+    sal_Int64 released;
+};
+
+struct LiveInterface {
+    rtl::OUString typeName;
+    sal_Int64 references;
+};
+
+// The tables below are never destroyed, so that they are still there when
+// the counters are dumped at exit.
+
+osl::Mutex & trackingMutex () {
+    static osl::Mutex * mutex = new osl::Mutex;
+    return *mutex;
+}
+
+// counts per type name, sorted for the dump
+std::map<rtl::OUString, InterfaceCount> & interfaceCounts () {
+    static std::map<rtl::OUString, InterfaceCount> * counts
+        = new std::map<rtl::OUString, InterfaceCount>;
+    return *counts;
+}
+
+// type names of the interfaces currently held, to attribute releases
+std::unordered_map<void *, LiveInterface> & liveInterfaces () {
+    static std::unordered_map<void *, LiveInterface> * live
+        = new std::unordered_map<void *, LiveInterface>;
+    return *live;
+}
+
+rtl::OUString const unknownTypeName ("<unknown>");
+
+void dumpAtExit () {
+    hsunoAccountingDump();
+}
+
+struct Init {
+    Init () {
+        if (std::getenv("HSUNO_STATS") != 0) {
+            tracking = true;
+            std::atexit(dumpAtExit);
+        }
+    }
+} init;
+
+}
+
+void hsunoAccountingCount (HsunoCounter counter, sal_Int64 n)
+{
+    counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void hsunoAccountingInterfaceAcquired (void * pInterface,
+    rtl_uString * pTypeName)
+{
+    hsunoAccountingCount(HSUNO_COUNT_INTERFACE_ACQUIRED);
+    if (!tracking.load(std::memory_order_relaxed))
+        return;
+    osl::MutexGuard guard (trackingMutex());
+    LiveInterface & live (liveInterfaces()[pInterface]);
+    if (live.references == 0)
+        live.typeName = pTypeName != 0 ? rtl::OUString(pTypeName)
+            : unknownTypeName;
+    ++live.references;
+    ++interfaceCounts()[live.typeName].acquired;
+}
+
+void hsunoAccountingInterfaceReleased (void * pInterface)
+{
+    hsunoAccountingCount(HSUNO_COUNT_INTERFACE_RELEASED);
+    if (!tracking.load(std::memory_order_relaxed))
+        return;
+    osl::MutexGuard guard (trackingMutex());
+    std::unordered_map<void *, LiveInterface>::iterator it (
+        liveInterfaces().find(pInterface));
+    if (it == liveInterfaces().end()) {
+        // acquired before tracking was enabled, or outside the binding
+        ++interfaceCounts()[unknownTypeName].released;
+        return;
+    }
+    ++interfaceCounts()[it->second.typeName].released;
+    if (--it->second.references == 0)
+        liveInterfaces().erase(it);
+}
+
+extern "C"
+sal_Int64 hsunoAccountingGetCounter (int counter)
+{
+    assert(counter >= 0 && counter < HSUNO_COUNTERS);
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+extern "C"
+void hsunoAccountingSetTracking (sal_Bool bTracking)
+{
+    tracking = bTracking;
+}
+
+extern "C"
+sal_Int32 hsunoAccountingGetInterfaceCounts (sal_Int32 nMax,
+    rtl_uString ** ppTypeNames, sal_Int64 * pAcquired, sal_Int64 * pReleased)
+{
+    osl::MutexGuard guard (trackingMutex());
+    sal_Int32 i = 0;
+    for (auto const & count : interfaceCounts()) {
+        if (i < nMax) {
+            ppTypeNames[i] = count.first.pData;
+            rtl_uString_acquire(ppTypeNames[i]);
+            pAcquired[i] = count.second.acquired;
+            pReleased[i] = count.second.released;
+        }
+        ++i;
+    }
+    return i;
+}
+
+extern "C"
+void hsunoAccountingDump ()
+{
+    std::fprintf(stderr, "hsuno accounting:\n");
+    for (int i = 0 ; i < HSUNO_COUNTERS ; ++i)
+        std::fprintf(stderr, "  %-22s %12lld\n", counterNames[i],
+            static_cast< long long >(hsunoAccountingGetCounter(i)));
+    osl::MutexGuard guard (trackingMutex());
+    if (interfaceCounts().empty())
+        return;
+    std::fprintf(stderr, "  interfaces by type (acquired released live):\n");
+    for (auto const & count : interfaceCounts()) {
+        rtl::OString name (rtl::OUStringToOString(count.first,
+            RTL_TEXTENCODING_UTF8));
+        std::fprintf(stderr, "    %s %lld %lld %lld\n", name.getStr(),
+            static_cast< long long >(count.second.acquired),
+            static_cast< long long >(count.second.released),
+            static_cast< long long >(
+                count.second.acquired - count.second.released));
+    }
+}
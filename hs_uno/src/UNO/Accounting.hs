@@ -0,0 +1,76 @@
+module UNO.Accounting
+  ( Counter (..)
+  , getCounter
+  , getCounters
+  , getInterfaceCounts
+  , setInterfaceTracking
+  , dumpAccounting
+  ) where
+
+import Control.Applicative ((<$>))
+import Control.Monad
+import Data.Text (Text)
+import Foreign
+import Foreign.C
+
+import UNO.Text
+
+-- |The objects counted by the binding.  Must be kept in sync with
+-- HsunoCounter in Accounting.hxx.
+data Counter
+  = InterfacesAcquired
+  | InterfacesReleased
+  | OUStringsCreated
+  | OUStringsFreed
+  | UStringsCreated
+  | UStringsFreed
+  | AnysConstructed
+  | AnysDestructed
+  | AnysAllocated
+  | AnysFreed
+  | SequencesAcquired
+  | SequencesReleased
+  deriving (Eq, Ord, Show, Enum, Bounded)
+
+getCounter :: Counter -> IO Int64
+getCounter = cGetCounter . fromIntegral . fromEnum
+
+getCounters :: IO [(Counter, Int64)]
+getCounters = forM [minBound .. maxBound] $ \ c -> (,) c <$> getCounter c
+
+-- |The interfaces acquired and released per type name.
+--
+-- Only counted while tracking is enabled, see 'setInterfaceTracking'.
+getInterfaceCounts :: IO [(Text, Int64, Int64)]
+getInterfaceCounts = do
+  n <- cGetInterfaceCounts 0 nullPtr nullPtr nullPtr
+  -- more types may have been counted in the meantime
+  allocaArray (fromIntegral n) $ \ pNames ->
+    allocaArray (fromIntegral n) $ \ pAcquired ->
+      allocaArray (fromIntegral n) $ \ pReleased -> do
+        m <- min n <$> cGetInterfaceCounts n pNames pAcquired pReleased
+        forM [0 .. fromIntegral m - 1] $ \ i -> do
+          pName <- peekElemOff pNames i
+          name <- uStringToText pName
+          uStringRelease pName
+          acquired <- peekElemOff pAcquired i
+          released <- peekElemOff pReleased i
+          return (name, acquired, released)
+
+-- |Enable or disable counting interfaces per type name.  It is enabled
+-- from the start when the HSUNO_STATS environment variable is set.
+setInterfaceTracking :: Bool -> IO ()
+setInterfaceTracking b = cSetTracking (fromBool b)
+
+-- |Write all counters to stderr, as done at exit when HSUNO_STATS is set.
+foreign import ccall "hsunoAccountingDump" dumpAccounting
+  :: IO ()
+
+foreign import ccall unsafe "hsunoAccountingGetCounter" cGetCounter
+  :: CInt -> IO Int64
+
+foreign import ccall unsafe "hsunoAccountingSetTracking" cSetTracking
+  :: CUChar -> IO ()
+
+foreign import ccall "hsunoAccountingGetInterfaceCounts" cGetInterfaceCounts
+  :: Int32 -> Ptr (Ptr UString) -> Ptr Int64 -> Ptr Int64 -> IO Int32
@@ -0,0 +1,67 @@
+#ifndef HSUNO_UNO_ACCOUNTING_H
+#define HSUNO_UNO_ACCOUNTING_H
+
+#include "rtl/ustring.h"
+#include "sal/types.h"
+
+/** Accounting
+ *
+ * Counters of the objects the binding creates and frees, to track down leaks.
+ * Objects are counted where they cross into Haskell (in the generated stubs
+ * and the runtime's entry points) and where Haskell gives them back, so that
+ * the counts of a balanced program match; what the runtime uses internally is
+ * not counted.  The counters are always maintained.  Counting interfaces per
+ * type name is more expensive and only done when enabled, either by setting
+ * the HSUNO_STATS environment variable (which also dumps all counters to
+ * stderr at exit) or by hsunoAccountingSetTracking.
+ */
+
+enum HsunoCounter {
+    HSUNO_COUNT_INTERFACE_ACQUIRED,
+    HSUNO_COUNT_INTERFACE_RELEASED,
+    HSUNO_COUNT_OUSTRING_CREATED,
+    HSUNO_COUNT_OUSTRING_FREED,
+    HSUNO_COUNT_USTRING_CREATED,
+    HSUNO_COUNT_USTRING_FREED,
+    HSUNO_COUNT_ANY_CONSTRUCTED,
+    HSUNO_COUNT_ANY_DESTRUCTED,
+    HSUNO_COUNT_ANY_ALLOCATED,
+    HSUNO_COUNT_ANY_FREED,
+    HSUNO_COUNT_SEQUENCE_ACQUIRED,
+    HSUNO_COUNT_SEQUENCE_RELEASED,
+    HSUNO_COUNTERS
+};
+
+void hsunoAccountingCount (HsunoCounter counter, sal_Int64 n = 1);
+
+/** Count an interface handed over to the binding.
+ *
+ * pTypeName may be 0 when the type is not known (e.g. when acquiring an
+ * interface again), in which case the type it was first counted with is used.
+ */
+void hsunoAccountingInterfaceAcquired (void * pInterface,
+    rtl_uString * pTypeName);
+
+void hsunoAccountingInterfaceReleased (void * pInterface);
+
+extern "C"
+sal_Int64 hsunoAccountingGetCounter (int counter);
+
+extern "C"
+void hsunoAccountingSetTracking (sal_Bool bTracking);
+
+/** Retrieve the interface counts per type name.
+ *
+ * Fills in at most nMax entries and returns the number of type names; the
+ * names are acquired.
+ */
+extern "C"
+sal_Int32 hsunoAccountingGetInterfaceCounts (sal_Int32 nMax,
+    rtl_uString ** ppTypeNames, sal_Int64 * pAcquired, sal_Int64 * pReleased);
+
+/** Write all counters to stderr.
+ */
+extern "C"
+void hsunoAccountingDump ();
+
+#endif // HSUNO_UNO_ACCOUNTING_H
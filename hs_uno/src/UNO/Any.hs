@@ -3,13 +3,17 @@ module UNO.Any where
 
 import qualified UNO.Binary as B
 import UNO.Reference
+import UNO.Scope
 import UNO.Text
 import UNO.Types
 
-import Control.Applicative ((<$>))
+import Control.Applicative ((<$>), (<*>))
+import Control.Exception (finally)
 import Data.Text (Text)
 import Foreign
+import qualified Foreign.Concurrent as FC
 import Prelude hiding (any)
+import System.IO.Unsafe (unsafeInterleaveIO)
 
 data Any
   = AVoid
@@ -25,20 +29,71 @@ data Any
   | AFloat  Float
   | ADouble Double
   | AString Text
-  | AType   () -- TODO
-  | AEnum   Int
-  | AStruct () -- TODO
+  | AType   Text
+  -- |An enum value, given by its type name.
+  | AEnum   Text Int32
+  -- |An enum value, given by its type description, as generated code makes
+  -- them; it is put into an Any without looking its type up.
+  | AEnumOf TypeDescriptionPtr Int32
+  -- |A struct, given by its type name, kept in the Any holding it.
+  | AStruct Text AnyView
+  -- |An exception, given by its type name, kept in the Any holding it.
+  | AException Text AnyView
+  -- |A sequence, given by its type name, pointing into the Any holding it.
+  | ASequence Text (ForeignPtr (CSequence ()))
   | AInterface Text (ForeignPtr ())
+  -- |An Any that has not been decoded, passed on as is.
+  | AView AnyView
+
+-- *Lazy Anys
+
+-- |A UNO Any owned by Haskell, decoded on demand.
+newtype AnyView = AnyView (ForeignPtr B.Any)
+
+-- |Take ownership of a constructed Any allocated by hsuno_any_new (as the
+-- results of calls are).
+anyViewFromUno :: Ptr B.Any -> IO AnyView
+anyViewFromUno pAny = AnyView <$> newForeignPtr B.anyFreePtr pAny
+
+-- |Make a view of a copy of an Any.  The value is shared, not copied.
+anyViewCopy :: Ptr B.Any -> IO AnyView
+anyViewCopy pAny = do
+  pCopy <- B.anyNew
+  B.anyCopy pCopy pAny
+  anyViewFromUno pCopy
+
+withAnyView :: AnyView -> (Ptr B.Any -> IO a) -> IO a
+withAnyView (AnyView fp) = withForeignPtr fp
+
+anyViewTypeClass :: AnyView -> IO TypeClass
+anyViewTypeClass v = withAnyView v $ \ pAny -> toEnum <$> B.anyGetTypeClass pAny
+
+anyViewTypeName :: AnyView -> IO Text
+anyViewTypeName v = withAnyView v $ \ pAny ->
+  uStringToText =<< B.anyGetTypeName pAny
+
+-- |Decode the top level of an Any.
+--
+-- Sequences, structs and exceptions are not copied but refer to the view;
+-- type names are only converted when used.
+viewAny :: AnyView -> IO Any
+viewAny v = withAnyView v $ decodeAny (Just v)
 
 -- *Convertion from and to UNO
 
+-- |Decode an Any, which stays owned by the caller.
 anyFromUno :: Ptr B.Any -> IO Any
-anyFromUno pAny = do
+anyFromUno = decodeAny Nothing
+
+decodeAny :: Maybe AnyView -> Ptr B.Any -> IO Any
+decodeAny view pAny = do
   t <- toEnum <$> B.anyGetTypeClass pAny
   case t of
     Typelib_TypeClass_VOID           -> return AVoid
-    Typelib_TypeClass_CHAR           -> AChar   <$> anyValue pAny
-    Typelib_TypeClass_BOOLEAN        -> ABool   <$> anyValue pAny
+    Typelib_TypeClass_CHAR           -> AChar . toEnum . fromIntegral
+                                          <$> (anyValue pAny :: IO Word16)
+    Typelib_TypeClass_BOOLEAN        -> ABool . (/= 0)
+                                          <$> (anyValue pAny :: IO Word8)
     Typelib_TypeClass_BYTE           -> AByte   <$> anyValue pAny
     Typelib_TypeClass_SHORT          -> AShort  <$> anyValue pAny
     Typelib_TypeClass_UNSIGNED_SHORT -> AUShort <$> anyValue pAny
@@ -48,43 +103,79 @@ anyFromUno pAny = do
     Typelib_TypeClass_UNSIGNED_HYPER -> AUHyper <$> anyValue pAny
     Typelib_TypeClass_FLOAT          -> AFloat  <$> anyValue pAny
     Typelib_TypeClass_DOUBLE         -> ADouble <$> anyValue pAny
-    Typelib_TypeClass_STRING         -> AString <$> (hs_oustring_to_text =<< anyValue pAny)
-    Typelib_TypeClass_TYPE           -> error "[anyFromUno] not implemented (type)" -- TODO
-    Typelib_TypeClass_ENUM           -> AEnum   <$> anyValue pAny
-    Typelib_TypeClass_STRUCT         -> error "[anyFromUno] not implemented (struct)" -- TODO
-    Typelib_TypeClass_EXCEPTION      -> error "[anyFromUno] not implemented (exception)" -- TODO
-    Typelib_TypeClass_SEQUENCE       -> error "[anyFromUno] not implemented (sequence)" -- TODO
+    Typelib_TypeClass_STRING         -> AString <$> (uStringToText =<< anyValue pAny)
+    Typelib_TypeClass_TYPE           -> AType   <$> (uStringToText
+                                          =<< typeRefGetName =<< anyValue pAny)
+    Typelib_TypeClass_ENUM           -> AEnum <$> typeName <*> anyValue pAny
+    Typelib_TypeClass_STRUCT         -> AStruct <$> typeName <*> owner
+    Typelib_TypeClass_EXCEPTION      -> AException <$> typeName <*> owner
+    Typelib_TypeClass_SEQUENCE       -> do
+      AnyView fp <- owner
+      pSequence <- withForeignPtr fp anyValue
+      ASequence <$> typeName
+        <*> FC.newForeignPtr pSequence (touchForeignPtr fp)
     Typelib_TypeClass_INTERFACE      -> do
       v <- anyValue pAny :: IO (Ptr a)
-      tn <- uStringToText =<< B.anyGetTypeName pAny
-      -- B.cInterfaceAcquire v
-      AInterface tn <$> newForeignPtr B.cInterfaceReleasePtr v
+      B.cInterfaceAcquireTyped v =<< B.anyGetTypeName pAny
+      AInterface <$> typeName <*> (fst <$> adoptInterface v)
+    _ -> error "[anyFromUno] invalid type class"
+  where
+    -- the view keeps the type alive until the name is needed
+    typeName = case view of
+      Just v  -> unsafeInterleaveIO (anyViewTypeName v)
+      Nothing -> uStringToText =<< B.anyGetTypeName pAny
+    owner = maybe (anyViewCopy pAny) return view
 
 anyToUno' :: Any -> Ptr B.Any -> IO ()
 anyToUno' (AVoid) =
   \ pAny -> B.anyConstruct pAny nullPtr nullPtr B.cInterfaceAcquirePtr
-anyToUno' (AChar   v) = createUNOAny v
-anyToUno' (ABool   v) = createUNOAny v
-anyToUno' (AByte   v) = createUNOAny v
-anyToUno' (AShort  v) = createUNOAny v
-anyToUno' (AUShort v) = createUNOAny v
-anyToUno' (ALong   v) = createUNOAny v
-anyToUno' (AULong  v) = createUNOAny v
-anyToUno' (AHyper  v) = createUNOAny v
-anyToUno' (AUHyper v) = createUNOAny v
-anyToUno' (AFloat  v) = createUNOAny v
-anyToUno' (ADouble v) = createUNOAny v
+anyToUno' (AChar   v) = integerToUno Typelib_TypeClass_CHAR (fromEnum v)
+anyToUno' (ABool   v) = integerToUno Typelib_TypeClass_BOOLEAN (fromEnum v)
+anyToUno' (AByte   v) = integerToUno Typelib_TypeClass_BYTE v
+anyToUno' (AShort  v) = integerToUno Typelib_TypeClass_SHORT v
+anyToUno' (AUShort v) = integerToUno Typelib_TypeClass_UNSIGNED_SHORT v
+anyToUno' (ALong   v) = integerToUno Typelib_TypeClass_LONG v
+anyToUno' (AULong  v) = integerToUno Typelib_TypeClass_UNSIGNED_LONG v
+anyToUno' (AHyper  v) = integerToUno Typelib_TypeClass_HYPER v
+anyToUno' (AUHyper v) = integerToUno Typelib_TypeClass_UNSIGNED_HYPER v
+anyToUno' (AFloat  v) = \ pAny -> B.anyConstructFloat pAny (realToFrac v)
+anyToUno' (ADouble v) = \ pAny -> B.anyConstructDouble pAny (realToFrac v)
 anyToUno' (AString v) = \ pAny -> withUString v
   (\ pV -> createUNOAnyWithPtr pV pAny)
--- TODO
---  - Type
---  - Struct
+anyToUno' (AType   t) = \ pAny -> do
+  rType <- getTypeDescription t
+  withForeignPtr rType $ \ pType ->
+    with pType $ \ ppType -> createUNOAnyWithType "type" ppType pAny
+anyToUno' (AEnum   t v) = \ pAny -> with v $ \ pV ->
+  createUNOAnyWithType t pV pAny
+anyToUno' (AEnumOf fpType v) = \ pAny ->
+  withForeignPtr fpType $ \ pType -> B.anyConstructEnum pAny pType v
+anyToUno' (AStruct _ v) = anyViewToUno v
+anyToUno' (AException _ v) = anyViewToUno v
+anyToUno' (ASequence t fp) = \ pAny ->
+  withForeignPtr fp $ \ p ->
+    with p $ \ pp -> createUNOAnyWithType t pp pAny
 anyToUno' (AInterface t fp) = \ pAny -> do
   rType <- getTypeDescription t
   withForeignPtr rType $ \ pType ->
     withForeignPtr fp $ \ p ->
       B.anyConstruct pAny p pType B.cInterfaceAcquirePtr
-anyToUno' _ = error "[anyToUno'] not yet implemented" -- TODO
+anyToUno' (AView v) = anyViewToUno v
+
+anyViewToUno :: AnyView -> Ptr B.Any -> IO ()
+anyViewToUno v pAny = withAnyView v $ B.anyCopy pAny
+
+createUNOAnyWithType :: Text -> Ptr a -> Ptr B.Any -> IO ()
+createUNOAnyWithType t pA pAny = do
+  rType <- getTypeDescription t
+  withForeignPtr rType $ \ pType ->
+    B.anyConstruct pAny pA pType B.cInterfaceAcquirePtr
+
+-- |Construct an Any of a primitive type without looking up its type.
+integerToUno :: Integral a => TypeClass -> a -> Ptr B.Any -> IO ()
+integerToUno tc v pAny =
+  B.anyConstructInteger pAny (fromIntegral (fromEnum tc)) (fromIntegral v)
+{-# INLINE integerToUno #-}
 
 createUNOAny :: (IsUnoType a, Storable a) => a -> Ptr B.Any -> IO ()
 createUNOAny a pAny = with a $ \ pA -> createUNOAnyWithPtr pA pAny
@@ -103,6 +194,18 @@ withAny any f = allocaBytes B.anyStructSize $ \ pAny -> do
   anyToUno' any pAny
   f pAny
 
+-- |Convert values into an array of uninitialized Anys, run an action and
+-- destruct the Anys again.  If a conversion throws, the Anys converted
+-- before it are destructed.
+withAnyArray :: [Any] -> Ptr B.Any -> IO a -> IO a
+withAnyArray anys pAnys f = go 0 anys
+  where
+    go _ [] = f
+    go i (a : as) = do
+      let pAny = pAnys `plusPtr` (i * B.anyStructSize)
+      anyToUno' a pAny
+      go (i + 1) as `finally` B.anyDestruct pAny nullFunPtr
+
 -- *Insertion and extraction of values
 
 class Anyable a where
@@ -173,21 +276,37 @@ instance Anyable Double where
   fromAny (ADouble v) = v
   fromAny _ = error "cannot extract to DOUBLE"
 
+instance Anyable Text where
+  toAny = AString
+  fromAny (AString v) = v
+  fromAny _ = error "cannot extract to STRING"
+
+instance Anyable Any where
+  toAny = id
+  fromAny = id
+
+-- |Values that may be void.
+instance Anyable a => Anyable (Maybe a) where
+  toAny = maybe AVoid toAny
+  fromAny AVoid = Nothing
+  fromAny v = Just (fromAny v)
+  fromAnyIO AVoid = return Nothing
+  fromAnyIO v = Just <$> fromAnyIO v
+
 -- TODO
---  - Text / String
 --  - Type
 --  - Struct
 
 instance IsUnoType a => Anyable (Reference a) where
-    toAny (Ref i) = AInterface (getUnoTypeName (undefined :: a))
+    toAny (Ref i _) = AInterface (getUnoTypeName (undefined :: a))
                                (castForeignPtr i)
-    fromAny (AInterface tn0 i) = getCorrectInterface $ Ref (castForeignPtr i)
+    fromAny (AInterface tn0 i) = getCorrectInterface $ Ref (castForeignPtr i) Nothing
       where tn1 = getUnoTypeName (undefined :: a)
             getCorrectInterface = if tn0 == tn1
                                   then id
                                   else error "need to query for interface"
     fromAny _ = error "invalid type"
-    fromAnyIO (AInterface tn0 i) = getCorrectInterface $ Ref (castForeignPtr i)
+    fromAnyIO (AInterface tn0 i) = getCorrectInterface $ Ref (castForeignPtr i) Nothing
       where tn1 = getUnoTypeName (undefined :: a)
             getCorrectInterface = if tn0 == tn1 then return else queryInterface
     fromAnyIO _ = error "invalid type"
@@ -1,13 +1,30 @@
 #include "Binary.hxx"
+#include "Accounting.hxx"
 
 #include "cppuhelper/bootstrap.hxx"
 #include "uno/dispatcher.h"
 #include "com/sun/star/uno/Any.hxx"
+#include "com/sun/star/uno/Exception.hpp"
+#include "com/sun/star/uno/RuntimeException.hpp"
 #include "sal/main.h"
 #include "com/sun/star/uno/Sequence.hxx"
+#include "osl/mutex.hxx"
+#include "sal/log.hxx"
+
+#include <atomic>
+#include <vector>
+#include <unordered_map>
 
 using ::com::sun::star::uno::Any;
 
+namespace {
+
+class ContextCache;
+
+ContextCache * getContextCache (uno_Interface * pContext);
+
+}
+
 extern "C"
 void * bootstrap(int argc, char ** argv)
 {
@@ -19,6 +36,8 @@ void * bootstrap(int argc, char ** argv)
     void * unoContext = cpp2uno.mapInterface( context.get(),
         cppu::UnoType< com::sun::star::uno::XComponentContext >::get() );
     assert(unoContext != 0);
+    // set up the cache of the bootstrap context right away
+    getContextCache(static_cast< uno_Interface * >(unoContext));
     return unoContext;
 }
 
@@ -28,14 +47,14 @@ uno_Interface * hsunoQueryInterfaceByName (uno_Interface * iface,
 {
   typelib_TypeDescription * td = 0;
   typelib_typedescription_getByName(((typelib_TypeDescription **)&td), psName);
-  uno_Interface * ret = hsunoQueryInterface(iface,
+  uno_Interface * ret = hsunoQueryInterfaceUncounted(iface,
       (typelib_TypeDescriptionReference *)td);
   typelib_typedescription_release(td);
   return ret;
 }
 
 extern "C"
-uno_Interface * hsunoQueryInterface (uno_Interface * iface,
+uno_Interface * hsunoQueryInterfaceUncounted (uno_Interface * iface,
     typelib_TypeDescriptionReference * pType)
 {
   uno_Any result, exception;
@@ -45,51 +64,300 @@ uno_Interface * hsunoQueryInterface (uno_Interface * iface,
   makeBinaryUnoCall(iface, "com.sun.star.uno.XInterface::queryInterface",
       &result, arguments, &pException);
   assert(pException == 0); // TODO handle exception
-  // FIXME the following code may leak due to the use of an Any
+  // the reference held by the Any is handed over to the caller
   if (result.pType->eTypeClass == typelib_TypeClass_INTERFACE)
     return (uno_Interface *)result.pReserved;
+  uno_any_destruct(&result, 0);
   return 0;
 }
 
+extern "C"
+uno_Interface * hsunoQueryInterface (uno_Interface * iface,
+    typelib_TypeDescriptionReference * pType)
+{
+  uno_Interface * ret = hsunoQueryInterfaceUncounted(iface, pType);
+  if (ret != 0)
+    hsunoAccountingInterfaceAcquired(ret, pType->pTypeName);
+  return ret;
+}
 
 extern "C"
-uno_Interface * hsunoCreateInstanceWithContext (rtl_uString * sServiceSpecifier,
-    uno_Interface * pContext)
+void hsunoQueryInterfaces (uno_Interface * iface, sal_Int32 nTypes,
+    typelib_TypeDescriptionReference ** ppTypes, uno_Interface ** ppResults)
 {
-  rtl_uString_acquire(sServiceSpecifier);
+  for (sal_Int32 i = 0 ; i < nTypes ; ++i)
+    ppResults[i] = hsunoQueryInterface(iface, ppTypes[i]);
+}
+
+// Context cache
+//
+// Each context gets a cache, created on first use (or by bootstrap), that
+// holds its XComponentContext interface, its service manager, the component
+// factories of the services created through it and the singletons obtained
+// from it.  Caches are keyed by the context pointer; the cache keeps the
+// context alive until it is revoked.  The interfaces and Anys the cache holds
+// never reach Haskell and are not counted by the accounting.
+//
+// A service with a single implementation is created through that
+// implementation's factory instead of through the service manager.  This
+// costs one createContentEnumeration round trip the first time the service is
+// created, and it skips whatever the service manager itself does on
+// createInstanceWithContext, e.g. a manager that wraps, tracks or hands out
+// one shared instance per service; a one-instance factory still returns its
+// single instance.  Services with several implementations, or none, go
+// through the service manager as before.
+
+namespace {
+
+void releaseInterface (uno_Interface * pInterface) {
+  if (pInterface != 0)
+    (*pInterface->release)(pInterface);
+}
 
+class ContextCache {
+  public:
+    explicit ContextCache (uno_Interface * pContext);
+    ~ContextCache ();
+    uno_Interface * createInstance (rtl_uString * sServiceSpecifier);
+    void getSingleton (rtl_uString * sSingletonSpecifier, uno_Any * result);
+  private:
+    uno_Interface * findFactory (rtl::OUString const & sServiceSpecifier);
+
+    osl::Mutex mutex;
+    uno_Interface * pContext;
+    uno_Interface * xComponentContext;
+    uno_Interface * xServiceManager;
+    // XSingleComponentFactory per service name, or 0 when the service
+    // manager has to be used
+    std::unordered_map< rtl::OUString, uno_Interface *, rtl::OUStringHash >
+      factories;
+    std::unordered_map< rtl::OUString, uno_Any, rtl::OUStringHash > singletons;
+};
+
+ContextCache::ContextCache (uno_Interface * pContext)
+  : pContext(pContext), xComponentContext(0), xServiceManager(0)
+{
+  (*pContext->acquire)(pContext);
   uno_Any exception;
   uno_Any * pException = &exception;
+  // FIXME the queryInterface should not be needed
+  rtl::OUString sXComponentContext ("com.sun.star.uno.XComponentContext");
+  xComponentContext = hsunoQueryInterfaceByName(pContext,
+      sXComponentContext.pData);
+  makeBinaryUnoCall(xComponentContext,
+      "com.sun.star.uno.XComponentContext::getServiceManager",
+      &xServiceManager, NULL, &pException);
+  assert(pException == 0); // TODO handle exception
+}
 
-  uno_Interface * xComponentContext = 0;
-  uno_Interface * pServiceManager = 0;
+ContextCache::~ContextCache () {
+  for (auto & factory : factories)
+    releaseInterface(factory.second);
+  for (auto & singleton : singletons)
+    uno_any_destruct(&singleton.second, 0);
+  releaseInterface(xServiceManager);
+  releaseInterface(xComponentContext);
+  releaseInterface(pContext);
+}
+
+uno_Interface * ContextCache::findFactory (rtl::OUString const & sServiceSpecifier)
+{
+  uno_Any exception;
+  uno_Any * pException = &exception;
+  rtl::OUString sXContentEnumerationAccess (
+      "com.sun.star.container.XContentEnumerationAccess");
+  uno_Interface * xAccess = hsunoQueryInterfaceByName(xServiceManager,
+      sXContentEnumerationAccess.pData);
+  if (xAccess == 0)
+    return 0;
+  uno_Interface * xEnumeration = 0;
   {
-    // FIXME the queryInterface should not be needed
-    rtl_uString * sXComponentContext = 0;
-    rtl_uString_newFromAscii(&sXComponentContext,
-        "com.sun.star.uno.XComponentContext");
-    xComponentContext = hsunoQueryInterfaceByName(pContext, sXComponentContext);
-    rtl_uString_release(sXComponentContext);
-    makeBinaryUnoCall(xComponentContext,
-    //makeBinaryUnoCall(pContext,
-        "com.sun.star.uno.XComponentContext::getServiceManager",
-        &pServiceManager, NULL, &pException);
+    void * arguments [1];
+    rtl_uString * pServiceSpecifier = sServiceSpecifier.pData;
+    arguments[0] = &pServiceSpecifier;
+    makeBinaryUnoCall(xAccess,
+        "com.sun.star.container.XContentEnumerationAccess::createContentEnumeration",
+        &xEnumeration, arguments, &pException);
+    assert(pException == 0); // TODO handle exception
+  }
+  releaseInterface(xAccess);
+  if (xEnumeration == 0)
+    return 0;
+  // only use the factory when it is the single implementation of the
+  // service, otherwise leave the choice to the service manager
+  std::vector< uno_Interface * > found;
+  for (;;) {
+    sal_Bool bMore = sal_False;
+    pException = &exception;
+    makeBinaryUnoCall(xEnumeration,
+        "com.sun.star.container.XEnumeration::hasMoreElements", &bMore, NULL,
+        &pException);
     assert(pException == 0); // TODO handle exception
+    if (!bMore || found.size() > 1)
+      break;
+    uno_Any element;
+    pException = &exception;
+    makeBinaryUnoCall(xEnumeration,
+        "com.sun.star.container.XEnumeration::nextElement", &element, NULL,
+        &pException);
+    assert(pException == 0); // TODO handle exception
+    if (element.pType->eTypeClass == typelib_TypeClass_INTERFACE) {
+      rtl::OUString sXSingleComponentFactory (
+          "com.sun.star.lang.XSingleComponentFactory");
+      found.push_back(hsunoQueryInterfaceByName(
+            static_cast< uno_Interface * >(element.pReserved),
+            sXSingleComponentFactory.pData));
+    }
+    uno_any_destruct(&element, 0);
   }
+  releaseInterface(xEnumeration);
+  if (found.size() == 1)
+    return found[0];
+  for (auto pFactory : found)
+    releaseInterface(pFactory);
+  return 0;
+}
 
-  uno_Interface * ret = 0;
+uno_Interface * ContextCache::createInstance (rtl_uString * sServiceSpecifier)
+{
+  rtl::OUString sService (sServiceSpecifier);
+  uno_Interface * xFactory = 0;
+  bool bFound = false;
   {
-    pException = &exception;
+    osl::MutexGuard guard (mutex);
+    auto it = factories.find(sService);
+    if (it != factories.end()) {
+      xFactory = it->second;
+      bFound = true;
+    }
+  }
+  if (!bFound) {
+    // look the factory up without the lock held, it is a remote call; when
+    // another thread got there first, keep its factory
+    uno_Interface * xNew = findFactory(sService);
+    osl::MutexGuard guard (mutex);
+    auto res = factories.insert(std::make_pair(sService, xNew));
+    if (!res.second)
+      releaseInterface(xNew);
+    xFactory = res.first->second;
+  }
+  // the cache may be revoked while the factory is in use
+  if (xFactory != 0)
+    (*xFactory->acquire)(xFactory);
+
+  uno_Any exception;
+  uno_Any * pException = &exception;
+  uno_Interface * ret = 0;
+  if (xFactory != 0) {
+    void * arguments [1];
+    arguments[0] = &xComponentContext;
+    makeBinaryUnoCall(xFactory,
+        "com.sun.star.lang.XSingleComponentFactory::createInstanceWithContext",
+        &ret, arguments, &pException);
+    releaseInterface(xFactory);
+  } else {
     void * arguments [2];
     arguments[0] = &sServiceSpecifier;
     arguments[1] = &xComponentContext;
-    makeBinaryUnoCall(pServiceManager,
+    makeBinaryUnoCall(xServiceManager,
         "com.sun.star.lang.XMultiComponentFactory::createInstanceWithContext",
         &ret, arguments, &pException);
-    assert(pException == 0); // TODO handle exception
   }
+  assert(pException == 0); // TODO handle exception
+  return ret;
+}
+
+void ContextCache::getSingleton (rtl_uString * sSingletonSpecifier,
+    uno_Any * result)
+{
+  rtl::OUString sSingleton (sSingletonSpecifier);
+  {
+    osl::MutexGuard guard (mutex);
+    auto it = singletons.find(sSingleton);
+    if (it != singletons.end()) {
+      uno_type_any_construct(result, it->second.pData, it->second.pType, 0);
+      return;
+    }
+  }
+  // resolve the singleton without the lock held, it is a remote call
+  void * arguments [1];
+  arguments[0] = &sSingletonSpecifier;
+  uno_Any value;
+  uno_Any exception;
+  uno_Any * pException = &exception;
+  makeBinaryUnoCall(xComponentContext,
+      "com.sun.star.uno.XComponentContext::getValueByName", &value,
+      arguments, &pException);
+  assert(pException == 0); // TODO handle exception
+  // do not cache a missing singleton
+  if (value.pType->eTypeClass != typelib_TypeClass_INTERFACE) {
+    uno_type_any_construct(result, value.pData, value.pType, 0);
+    uno_any_destruct(&value, 0);
+    return;
+  }
+  osl::MutexGuard guard (mutex);
+  auto res = singletons.insert(std::make_pair(sSingleton, uno_Any()));
+  // an Any may point into itself, so copy it in place; when another thread
+  // got there first, keep its value
+  if (res.second)
+    uno_type_any_construct(&res.first->second, value.pData, value.pType, 0);
+  uno_any_destruct(&value, 0);
+  uno_type_any_construct(result, res.first->second.pData,
+      res.first->second.pType, 0);
+}
+
+typedef std::unordered_map< uno_Interface *, ContextCache * > ContextCaches;
+
+osl::Mutex & contextCachesMutex () {
+  static osl::Mutex mutex;
+  return mutex;
+}
+
+// must be called with contextCachesMutex locked
+ContextCaches & contextCaches () {
+  static ContextCaches caches;
+  return caches;
+}
+
+ContextCache * getContextCache (uno_Interface * pContext) {
+  osl::MutexGuard guard (contextCachesMutex());
+  ContextCaches & caches (contextCaches());
+  ContextCaches::iterator it (caches.find(pContext));
+  if (it == caches.end())
+    it = caches.insert(std::make_pair(pContext, new ContextCache(pContext)))
+      .first;
+  return it->second;
+}
+
+} // anonymous namespace
+
+extern "C"
+void hsunoContextCacheRevoke (uno_Interface * pContext)
+{
+  ContextCache * cache = 0;
+  {
+    osl::MutexGuard guard (contextCachesMutex());
+    ContextCaches & caches (contextCaches());
+    ContextCaches::iterator it (caches.find(pContext));
+    if (it == caches.end())
+      return;
+    cache = it->second;
+    caches.erase(it);
+  }
+  delete cache;
+}
 
-  rtl_uString_release(sServiceSpecifier);
+extern "C"
+uno_Interface * hsunoCreateInstanceWithContext (rtl_uString * sServiceSpecifier,
+    uno_Interface * pContext)
+{
+  uno_Interface * ret =
+    getContextCache(pContext)->createInstance(sServiceSpecifier);
+  // the instance is handed over as an XInterface
+  if (ret != 0)
+    hsunoAccountingInterfaceAcquired(ret,
+        cppu::UnoType< css::uno::XInterface >::get().getTypeLibType()
+          ->pTypeName);
   return ret;
 }
 
@@ -108,15 +376,153 @@ extern "C"
 void hsunoGetSingletonFromContext (
     rtl_uString * sSingletonSpecifier, uno_Interface * pContext, uno_Any * result)
 {
-    void * arguments [1];
-    arguments[0] = &sSingletonSpecifier;
-    uno_Any exception;
-    uno_Any * pException = &exception;
-    makeBinaryUnoCall(pContext,
-        "com.sun.star.uno.XComponentContext::getValueByName", result,
-        arguments, &pException);
-    assert(pException == 0); // TODO handle exception
-    return;
+  getContextCache(pContext)->getSingleton(sSingletonSpecifier, result);
+  // the only value of the runtime's own calls that reaches Haskell
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+}
+
+// Method type description cache
+//
+// Descriptions are looked up once and then kept for the lifetime of the
+// process.  The fast path is keyed by the address of the method name, which
+// is a string literal in the generated stubs, and can be read without taking
+// any lock.  Names coming from elsewhere go through the by-name table.
+
+namespace {
+
+struct MethodCacheEntry {
+    std::atomic< char const * > name;
+    std::atomic< typelib_TypeDescription * > description;
+};
+
+// must be a power of two
+const std::size_t methodCacheSize = 4096;
+
+MethodCacheEntry methodCache [methodCacheSize];
+
+osl::Mutex & methodCacheMutex () {
+    static osl::Mutex mutex;
+    return mutex;
+}
+
+typedef std::unordered_map< std::string, typelib_TypeDescription * >
+    MethodsByName;
+
+MethodsByName & methodsByName () {
+    static MethodsByName methods;
+    return methods;
+}
+
+inline std::size_t methodCacheSlot (char const * methodType) {
+    std::size_t h = reinterpret_cast< std::size_t >(methodType);
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h & (methodCacheSize - 1);
+}
+
+// must be called with methodCacheMutex locked
+typelib_TypeDescription * lookupMethodDescription (char const * methodType) {
+    MethodsByName & methods (methodsByName());
+    MethodsByName::const_iterator it (methods.find(methodType));
+    if (it != methods.end())
+        return it->second;
+    typelib_TypeDescription * td = 0;
+    rtl::OUString name (rtl::OUString::createFromAscii(methodType));
+    typelib_typedescription_getByName(&td, name.pData);
+    if (td != 0)
+        methods[methodType] = td;
+    return td;
+}
+
+} // anonymous namespace
+
+extern "C"
+typelib_TypeDescription * hsunoGetMethodDescriptionByName (
+    char const * methodType)
+{
+    osl::MutexGuard guard (methodCacheMutex());
+    return lookupMethodDescription(methodType);
+}
+
+extern "C"
+typelib_TypeDescription * hsunoGetMethodDescription (char const * methodType)
+{
+    std::size_t slot = methodCacheSlot(methodType);
+    for (std::size_t i = 0 ; i < methodCacheSize ; ++i) {
+        MethodCacheEntry & entry (methodCache[(slot + i) & (methodCacheSize - 1)]);
+        char const * name = entry.name.load(std::memory_order_acquire);
+        if (name == methodType)
+            return entry.description.load(std::memory_order_relaxed);
+        if (name == 0)
+            break;
+    }
+    // slow path: resolve by name and publish the result
+    osl::MutexGuard guard (methodCacheMutex());
+    typelib_TypeDescription * td = lookupMethodDescription(methodType);
+    if (td == 0)
+        return 0;
+    for (std::size_t i = 0 ; i < methodCacheSize ; ++i) {
+        MethodCacheEntry & entry (methodCache[(slot + i) & (methodCacheSize - 1)]);
+        char const * name = entry.name.load(std::memory_order_relaxed);
+        if (name == methodType)
+            break;
+        if (name == 0) {
+            entry.description.store(td, std::memory_order_relaxed);
+            entry.name.store(methodType, std::memory_order_release);
+            break;
+        }
+    }
+    // when the table is full, the by-name table still avoids the typelib
+    return td;
+}
+
+// Only the by-name table is filled: the names passed here do not live at the
+// addresses the lock-free table is keyed by (and identical string literals of
+// different call sites need not share one address either).
+extern "C"
+void hsunoPrewarmMethodCache (char const ** methodTypes, sal_Int32 nMethodTypes)
+{
+    osl::MutexGuard guard (methodCacheMutex());
+    for (sal_Int32 i = 0 ; i < nMethodTypes ; ++i) {
+        typelib_TypeDescription * td = lookupMethodDescription(methodTypes[i]);
+        SAL_WARN_IF(td == 0, "hsuno", "unknown method " << methodTypes[i]);
+    }
+}
+
+namespace {
+
+// Count the values a successful call of a plan hands over to Haskell.
+void accountCallResult (typelib_TypeDescription const * td, void * result)
+{
+    if (result == 0)
+        return;
+    typelib_TypeDescriptionReference * pType =
+        td->eTypeClass == typelib_TypeClass_INTERFACE_METHOD
+        ? reinterpret_cast< typelib_InterfaceMethodTypeDescription const * >(
+            td)->pReturnTypeRef
+        : reinterpret_cast< typelib_InterfaceAttributeTypeDescription const * >(
+            td)->pAttributeTypeRef;
+    switch (pType->eTypeClass) {
+    case typelib_TypeClass_INTERFACE:
+        if (*static_cast< void ** >(result) != 0)
+            hsunoAccountingInterfaceAcquired(*static_cast< void ** >(result),
+                pType->pTypeName);
+        break;
+    case typelib_TypeClass_STRING:
+        hsunoAccountingCount(HSUNO_COUNT_USTRING_CREATED);
+        break;
+    case typelib_TypeClass_ANY:
+        hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+        break;
+    case typelib_TypeClass_SEQUENCE:
+        hsunoAccountingCount(HSUNO_COUNT_SEQUENCE_ACQUIRED);
+        break;
+    default:
+        break;
+    }
+}
+
 }
 
 extern "C"
@@ -124,14 +530,119 @@ void makeBinaryUnoCall(
     uno_Interface * interface, char const * methodType, void * result,
     void ** arguments, uno_Any ** exception)
 {
-    typelib_TypeDescription * td = 0;
-    css::uno::Type(css::uno::TypeClass_INTERFACE_METHOD, methodType)
-        .getDescription(&td);
+    typelib_TypeDescription * td = hsunoGetMethodDescription(methodType);
     assert(td != 0); // for now, just assert
     (*interface->pDispatcher)(interface, td, result, arguments, exception);
-    typelib_typedescription_release(td);
 }
 
+extern "C"
+HsunoInterfaceMembers const * hsunoGetInterfaceMembers (
+    char const * interfaceType)
+{
+    typelib_TypeDescription * td = 0;
+    rtl::OUString name (rtl::OUString::createFromAscii(interfaceType));
+    typelib_typedescription_getByName(&td, name.pData);
+    if (td == 0 || td->eTypeClass != typelib_TypeClass_INTERFACE) {
+        SAL_WARN("hsuno", "unknown interface " << interfaceType);
+        if (td != 0)
+            typelib_typedescription_release(td);
+        return 0;
+    }
+    if (!td->bComplete)
+        typelib_typedescription_complete(&td);
+    typelib_InterfaceTypeDescription * itd =
+        reinterpret_cast< typelib_InterfaceTypeDescription * >(td);
+    // the interface and member descriptions are kept for the process lifetime
+    HsunoInterfaceMembers * members = new HsunoInterfaceMembers;
+    members->nFirstDirectMember = itd->nAllMembers - itd->nMembers;
+    members->nAllMembers = itd->nAllMembers;
+    members->ppAllMembers = new typelib_TypeDescription * [itd->nAllMembers];
+    for (sal_Int32 i = 0 ; i < itd->nAllMembers ; ++i) {
+        members->ppAllMembers[i] = 0;
+        typelib_typedescriptionreference_getDescription(
+            &members->ppAllMembers[i], itd->ppAllMembers[i]);
+        assert(members->ppAllMembers[i] != 0);
+    }
+    return members;
+}
+
+extern "C"
+void makeBinaryUnoCallByPosition(
+    uno_Interface * interface, HsunoInterfaceMembers const * members,
+    sal_Int32 position, void * result, void ** arguments,
+    uno_Any ** exception)
+{
+    if (members == 0) {
+        // the stub's interface is not in the type registry
+        css::uno::RuntimeException e ("hsuno: unknown interface type");
+        uno_type_any_construct(*exception, &e,
+            cppu::UnoType< css::uno::RuntimeException >::get()
+                .getTypeLibType(), 0);
+        return;
+    }
+    sal_Int32 member = members->nFirstDirectMember + position;
+    assert(position >= 0 && member < members->nAllMembers);
+    (*interface->pDispatcher)(interface, members->ppAllMembers[member], result,
+        arguments, exception);
+}
+
+// Call plans
+
+extern "C"
+int hsunoCallPlan_structSize ()
+{
+    return sizeof(HsunoPlannedCall);
+}
+
+extern "C"
+void hsunoCallPlan_set (HsunoPlannedCall * pCalls, sal_Int32 nCall,
+    uno_Interface * pInterface, sal_Int32 nInterfaceFrom,
+    char const * pMethodType, void * pResult, void ** ppArguments)
+{
+    HsunoPlannedCall & call (pCalls[nCall]);
+    call.pInterface = pInterface;
+    call.nInterfaceFrom = nInterfaceFrom;
+    call.pMethodType = pMethodType;
+    call.pResult = pResult;
+    call.ppArguments = ppArguments;
+}
+
+extern "C"
+sal_Int32 hsunoExecuteCallPlan (HsunoPlannedCall const * pCalls,
+    sal_Int32 nCalls, uno_Any * pException)
+{
+    for (sal_Int32 i = 0 ; i < nCalls ; ++i) {
+        HsunoPlannedCall const & call (pCalls[i]);
+        uno_Interface * iface = call.pInterface;
+        if (iface == 0) {
+            assert(call.nInterfaceFrom >= 0 && call.nInterfaceFrom < i);
+            iface = *static_cast< uno_Interface ** >(
+                pCalls[call.nInterfaceFrom].pResult);
+        }
+        if (iface == 0) {
+            // an earlier call returned a null reference
+            uno_any_construct(pException, 0, 0, 0);
+            hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+            return i;
+        }
+        // method names from Haskell are not interned
+        typelib_TypeDescription * td =
+            hsunoGetMethodDescriptionByName(call.pMethodType);
+        assert(td != 0); // for now, just assert
+        uno_Any exception;
+        uno_Any * pExc = &exception;
+        (*iface->pDispatcher)(iface, td, call.pResult, call.ppArguments, &pExc);
+        if (pExc != 0) {
+            uno_type_any_construct(pException, exception.pData,
+                exception.pType, 0);
+            uno_any_destruct(&exception, 0);
+            hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+            return i;
+        }
+        accountCallResult(td, call.pResult);
+    }
+    return nCalls;
+}
 
 // Any
 
@@ -180,10 +691,90 @@ void * hsuno_any_getValue (uno_Any * pAny) {
   return pAny->pData;
 }
 
+void hsuno_any_construct (uno_Any * pAny, void * pData,
+    typelib_TypeDescription * pTypeDescr, uno_AcquireFunc acquire) {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  uno_any_construct(pAny, pData, pTypeDescr, acquire);
+}
+
 void hsuno_any_destruct (uno_Any * pAny, uno_ReleaseFunc release) {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_DESTRUCTED);
   uno_any_destruct(pAny, release);
 }
 
+rtl_uString * hsuno_any_getExceptionMessage (uno_Any * pAny) {
+  assert(pAny->pType->eTypeClass == typelib_TypeClass_EXCEPTION);
+  return static_cast< com::sun::star::uno::Exception * >(
+      pAny->pData)->Message.pData;
+}
+
+void hsuno_any_constructInteger (uno_Any * pAny, int typeClass,
+    sal_Int64 value) {
+  union {
+    sal_Bool b; sal_Int8 i8; sal_Int16 i16; sal_uInt16 u16; sal_Unicode c;
+    sal_Int32 i32; sal_uInt32 u32; sal_Int64 i64; sal_uInt64 u64;
+  } v;
+  switch (typeClass) {
+  case typelib_TypeClass_BOOLEAN: v.b = value != 0; break;
+  case typelib_TypeClass_BYTE: v.i8 = static_cast< sal_Int8 >(value); break;
+  case typelib_TypeClass_SHORT: v.i16 = static_cast< sal_Int16 >(value); break;
+  case typelib_TypeClass_UNSIGNED_SHORT:
+    v.u16 = static_cast< sal_uInt16 >(value); break;
+  case typelib_TypeClass_CHAR: v.c = static_cast< sal_Unicode >(value); break;
+  case typelib_TypeClass_LONG: v.i32 = static_cast< sal_Int32 >(value); break;
+  case typelib_TypeClass_UNSIGNED_LONG:
+    v.u32 = static_cast< sal_uInt32 >(value); break;
+  case typelib_TypeClass_HYPER: v.i64 = value; break;
+  case typelib_TypeClass_UNSIGNED_HYPER:
+    v.u64 = static_cast< sal_uInt64 >(value); break;
+  default:
+    assert(false); // not an integral type class
+  }
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  uno_type_any_construct(pAny, &v,
+      *typelib_static_type_getByTypeClass(
+          static_cast< typelib_TypeClass >(typeClass)), 0);
+}
+
+void hsuno_any_constructEnum (uno_Any * pAny, typelib_TypeDescription * pType,
+    sal_Int32 value) {
+  assert(pType->eTypeClass == typelib_TypeClass_ENUM);
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  uno_any_construct(pAny, &value, pType, 0);
+}
+
+void hsuno_any_constructFloat (uno_Any * pAny, float value) {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  uno_type_any_construct(pAny, &value,
+      *typelib_static_type_getByTypeClass(typelib_TypeClass_FLOAT), 0);
+}
+
+void hsuno_any_constructDouble (uno_Any * pAny, double value) {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  uno_type_any_construct(pAny, &value,
+      *typelib_static_type_getByTypeClass(typelib_TypeClass_DOUBLE), 0);
+}
+
+void hsuno_any_copy (uno_Any * pDest, uno_Any const * pSource) {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  uno_type_any_construct(pDest, pSource->pData, pSource->pType, 0);
+}
+
+uno_Any * hsuno_any_new () {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_ALLOCATED);
+  return new uno_Any;
+}
+
+void hsuno_any_delete (uno_Any * pAny) {
+  hsunoAccountingCount(HSUNO_COUNT_ANY_FREED);
+  delete pAny;
+}
+
+void hsuno_any_free (uno_Any * pAny) {
+  hsuno_any_destruct(pAny, 0);
+  hsuno_any_delete(pAny);
+}
+
 } // extern "C"
 
 // Sequence
@@ -201,6 +792,7 @@ const void * unoSequenceGetArray (uno_Sequence const * pSequence) {
 extern "C"
 void unoSequenceRelease (typelib_TypeDescription * td, uno_Sequence * pSequence)
 {
+    hsunoAccountingCount(HSUNO_COUNT_SEQUENCE_RELEASED);
     if (osl_atomic_decrement( &pSequence->nRefCount ) == 0) {
         uno_type_sequence_destroy( pSequence,
             reinterpret_cast< typelib_TypeDescriptionReference * >(td),
@@ -208,14 +800,56 @@ void unoSequenceRelease (typelib_TypeDescription * td, uno_Sequence * pSequence)
     }
 }
 
+extern "C"
+uno_Sequence * hsuno_sequence_construct (typelib_TypeDescription * pType,
+    void * pElements, sal_Int32 nElements)
+{
+    uno_Sequence * pSequence = 0;
+    // interface elements are all acquired here, in one go
+    uno_sequence_construct(&pSequence, pType, pElements, nElements, 0);
+    hsunoAccountingCount(HSUNO_COUNT_SEQUENCE_ACQUIRED);
+    return pSequence;
+}
+
+extern "C"
+void hsuno_sequence_adoptString (uno_Sequence * pSequence, sal_Int32 nIndex,
+    rtl_uString * pStr)
+{
+    assert(nIndex >= 0 && nIndex < pSequence->nElements);
+    rtl_uString ** ppElements =
+        reinterpret_cast< rtl_uString ** >(pSequence->elements);
+    rtl_uString_release(ppElements[nIndex]);
+    ppElements[nIndex] = pStr;
+    // the string is the sequence's now
+    hsunoAccountingCount(HSUNO_COUNT_USTRING_FREED);
+}
+
 // Interface
 
+// the acquire function of the Anys built from Haskell, whose references belong
+// to the Anys and are not counted
 extern "C"
 void cpp_acquire (void * pCppI) {
   com::sun::star::uno::cpp_acquire(pCppI);
 }
 
+// acquire an interface of the given type for Haskell
+extern "C"
+void hsunoInterfaceAcquire (void * pCppI, rtl_uString * pTypeName) {
+  hsunoAccountingInterfaceAcquired(pCppI, pTypeName);
+  com::sun::star::uno::cpp_acquire(pCppI);
+}
+
 extern "C"
 void cpp_release (void * pCppI) {
+  hsunoAccountingInterfaceReleased(pCppI);
   com::sun::star::uno::cpp_release(pCppI);
 }
+
+extern "C"
+void cpp_release_all (void ** ppCppI, sal_Int32 nCppI) {
+  for (sal_Int32 i = 0 ; i < nCppI ; ++i) {
+    hsunoAccountingInterfaceReleased(ppCppI[i]);
+    com::sun::star::uno::cpp_release(ppCppI[i]);
+  }
+}
@@ -9,8 +9,10 @@ import UNO.Types
 import UNO.Text
 
 import Control.Applicative ((<$>))
+import qualified Data.IntMap as IntMap
 import Foreign
 import Foreign.C
+import qualified Foreign.Concurrent as FC
 import System.Environment
 
 data UnoInterface
@@ -30,12 +32,36 @@ unoBootstrap = do
   withStringsArray (progname : args) $ \ argsPtr -> do
     cUnoBootstrap (1 + length args) argsPtr
 
+-- |Bootstrap and load the type descriptions of the given methods
+-- (@"Iface::method"@) into the method cache.
+unoBootstrapWithMethods :: [String] -> IO ContextPtr
+unoBootstrapWithMethods methods = do
+  ctx <- unoBootstrap
+  unoPrewarmMethodCache methods
+  return ctx
+
+-- |Load the type descriptions of the given methods (@"Iface::method"@) into
+-- the method cache, so the first calls do not pay for the typelib lookup.
+-- The warm-up is by name: the first call at each call site still takes the
+-- cache lock once.
+unoPrewarmMethodCache :: [String] -> IO ()
+unoPrewarmMethodCache methods = withStringsArray methods $ \ namesPtr ->
+  cHsunoPrewarmMethodCache namesPtr (fromIntegral (length methods))
+
 foreign import ccall "bootstrap" cUnoBootstrap
   :: Int -> Ptr CString -> IO ContextPtr
 
+foreign import ccall "hsunoPrewarmMethodCache" cHsunoPrewarmMethodCache
+  :: Ptr CString -> Int32 -> IO ()
+
 foreign import ccall "hsunoGetSingletonFromContext" hsunoGetSingletonFromContext
   :: Ptr UString -> Ptr Context -> Ptr Any -> IO ()
 
+-- |Drop the cached service manager, component factories and singletons of a
+-- context.  The cache is created again on the next use of the context.
+foreign import ccall "hsunoContextCacheRevoke" unoContextCacheRevoke
+  :: Ptr a -> IO ()
+
 -- *Any
 
 data UNOAny
@@ -65,21 +91,48 @@ type AnyPtr = Ptr Any
 foreign import ccall unsafe "hsuno_any_structSize" anyStructSize
   :: Int
 
-foreign import ccall "hsuno_any_getTypeClass" anyGetTypeClass
+foreign import ccall unsafe "hsuno_any_getTypeClass" anyGetTypeClass
   :: Ptr Any -> IO Int
 
-foreign import ccall "hsuno_any_getTypeName" anyGetTypeName
+foreign import ccall unsafe "hsuno_any_getTypeName" anyGetTypeName
   :: Ptr Any -> IO (Ptr UString)
 
-foreign import ccall "hsuno_any_getValue" anyGetValue
+foreign import ccall unsafe "hsuno_any_getExceptionMessage"
+  anyGetExceptionMessage :: Ptr Any -> IO (Ptr UString)
+
+foreign import ccall unsafe "hsuno_any_getValue" anyGetValue
   :: Ptr Any -> IO (Ptr a)
 
-foreign import ccall "uno_any_construct" anyConstruct
+foreign import ccall unsafe "hsuno_any_construct" anyConstruct
   :: Ptr Any -> Ptr a -> Ptr b -> FunPtr (Ptr c -> IO ()) -> IO ()
 
+foreign import ccall unsafe "hsuno_any_constructInteger" anyConstructInteger
+  :: Ptr Any -> CInt -> Int64 -> IO ()
+
+foreign import ccall unsafe "hsuno_any_constructEnum" anyConstructEnum
+  :: Ptr Any -> Ptr TypeDescription -> Int32 -> IO ()
+
+foreign import ccall unsafe "hsuno_any_constructFloat" anyConstructFloat
+  :: Ptr Any -> CFloat -> IO ()
+
+foreign import ccall unsafe "hsuno_any_constructDouble" anyConstructDouble
+  :: Ptr Any -> CDouble -> IO ()
+
 foreign import ccall "hsuno_any_destruct" anyDestruct
   :: Ptr Any -> FunPtr (Ptr a -> IO ()) -> IO ()
 
+foreign import ccall unsafe "hsuno_any_copy" anyCopy
+  :: Ptr Any -> Ptr Any -> IO ()
+
+foreign import ccall unsafe "hsuno_any_new" anyNew
+  :: IO (Ptr Any)
+
+foreign import ccall "hsuno_any_free" anyFree
+  :: Ptr Any -> IO ()
+
+foreign import ccall "&hsuno_any_free" anyFreePtr
+  :: FunPtr (Ptr Any -> IO ())
+
 -- *Sequence
 
 fromSequence
@@ -93,8 +146,20 @@ fromSequence fpSequence = withForeignPtr fpSequence $ \ pSequence -> do
   let seqElem = \ i -> arr `plusPtr` (i * elemSize)
   mapM (fromUno . seqElem) [0 .. len-1]
 
-toSequence :: IsUnoType a => [a] -> IO (ForeignPtr (CSequence a))
-toSequence = error "toSequence not implemented" -- TODO
+toSequence :: (IsUnoType a, Storable a) => [a] -> IO (ForeignPtr (CSequence a))
+toSequence xs = withArrayLen xs $ \ len pElements -> newSequence pElements len
+
+-- |Construct a sequence of the given elements, copied in one allocation.
+--
+-- A null element pointer gives default constructed elements.
+newSequence :: forall a . IsUnoType a => Ptr a -> Int -> IO (ForeignPtr (CSequence a))
+newSequence pElements len = do
+  -- type descriptions are cached for the lifetime of the process, so the
+  -- finalizer may keep the bare pointer
+  fpType <- getUnoType (undefined :: CSequence a)
+  withForeignPtr fpType $ \ pType -> do
+    pSequence <- cHsunoSequenceConstruct pType pElements (fromIntegral len)
+    newForeignPtrEnv cUnoSequenceReleaseFinalizer pType pSequence
 
 sequenceRelease :: forall a . IsUnoType a => Ptr (CSequence a) -> IO ()
 sequenceRelease pSequence = do
@@ -106,10 +171,16 @@ type SequenceRelease a = Ptr (CSequence a) -> IO ()
 foreign import ccall "wrapper"
   mkSequenceRelease :: SequenceRelease a -> IO (FunPtr (SequenceRelease a))
 
-foreign import ccall "unoSequenceGetLength" cUnoSequenceGetLength
+foreign import ccall "hsuno_sequence_construct" cHsunoSequenceConstruct
+  :: Ptr TypeDescription -> Ptr a -> Int32 -> IO (Ptr (CSequence a))
+
+foreign import ccall unsafe "hsuno_sequence_adoptString" cHsunoSequenceAdoptString
+  :: Ptr (CSequence UString) -> Int32 -> Ptr UString -> IO ()
+
+foreign import ccall unsafe "unoSequenceGetLength" cUnoSequenceGetLength
   :: Ptr (CSequence a) -> IO Int32
 
-foreign import ccall "unoSequenceGetArray" cUnoSequenceGetArray
+foreign import ccall unsafe "unoSequenceGetArray" cUnoSequenceGetArray
   :: Ptr (CSequence a) -> IO (Ptr a)
 
 foreign import ccall "unoSequenceRelease" cUnoSequenceRelease
@@ -121,27 +192,144 @@ foreign import ccall "&unoSequenceRelease" cUnoSequenceReleaseFinalizer
 -- *Interface
 
 queryInterface :: forall a b . IsUnoType b => ForeignPtr a -> IO (ForeignPtr b)
-queryInterface fpInterface = withForeignPtr fpInterface $ \ pInterface -> do
+queryInterface fpInterface =
+  queryInterfacePtr fpInterface >>= newForeignPtr cInterfaceReleasePtr
+
+-- |Query an interface, returning the acquired pointer (null if the object
+-- does not implement it).
+queryInterfacePtr :: forall a b . IsUnoType b => ForeignPtr a -> IO (Ptr b)
+queryInterfacePtr fpInterface = withForeignPtr fpInterface $ \ pInterface -> do
   fpType <- getUnoType (undefined :: b)
-  withForeignPtr fpType $ \ pType -> do
-    pIface <- cHsunoQueryInterface pInterface pType
-    newForeignPtr cInterfaceReleasePtr pIface
+  withForeignPtr fpType $ \ pType ->
+    cHsunoQueryInterface pInterface pType
 
 foreign import ccall "hsunoQueryInterface" cHsunoQueryInterface
   :: Ptr a -> Ptr b -> IO (Ptr c)
 
-foreign import ccall "cpp_acquire" cInterfaceAcquire
+foreign import ccall "hsunoQueryInterfaces" cHsunoQueryInterfaces
+  :: Ptr a -> Int32 -> Ptr (Ptr TypeDescription) -> Ptr (Ptr ()) -> IO ()
+
+foreign import ccall unsafe "cpp_acquire" cInterfaceAcquire
   :: Ptr a -> IO ()
 
 foreign import ccall "&cpp_acquire" cInterfaceAcquirePtr
   :: FunPtr (Ptr a -> IO ())
 
+foreign import ccall unsafe "hsunoInterfaceAcquire" cInterfaceAcquireTyped
+  :: Ptr a -> Ptr UString -> IO ()
+
 foreign import ccall "cpp_release" cInterfaceRelease
   :: Ptr a -> IO ()
 
 foreign import ccall "&cpp_release" cInterfaceReleasePtr
   :: FunPtr (Ptr a -> IO ())
 
+foreign import ccall "cpp_release_all" cInterfaceReleaseAll
+  :: Ptr (Ptr a) -> Int32 -> IO ()
+
+-- *Call Plans
+
+-- |A sequence of UNO calls executed in a single call into the runtime.
+--
+-- Later calls can use the results of earlier ones, as target interface or as
+-- argument.
+data CallPlan = CallPlan !Int [PlannedCall] -- the number of calls, and the
+                                            -- calls in reverse order
+
+data PlannedCall = PlannedCall
+  { callTarget     :: CallTarget
+  , callMethod     :: String        -- ^ @\"Iface::method\"@
+  , callResultSize :: Int           -- ^ size of the result, 0 for void
+  , callArguments  :: [CallArgument]
+  }
+
+data CallTarget
+  = TargetInterface (Ptr UnoInterface)
+  | TargetResultOf Int              -- ^ interface result of an earlier call
+
+data CallArgument
+  = ArgumentPtr (Ptr ())            -- ^ pointer to the argument value
+  | ArgumentResultOf Int            -- ^ result of an earlier call
+
+data CallPlanResult = CallPlanResult
+  { planResults   :: [ForeignPtr ()]
+  -- ^ result slots of the calls that returned, in call order; interfaces and
+  -- other non-plain values returned in them are owned by the caller
+  , planException :: Maybe (Int, ForeignPtr Any)
+  -- ^ the index of the failed call and the exception it raised
+  }
+
+emptyCallPlan :: CallPlan
+emptyCallPlan = CallPlan 0 []
+
+-- |Append a call to a plan, returning the index of the call.  The results it
+-- uses must be those of calls already in the plan.
+addCall :: PlannedCall -> CallPlan -> (Int, CallPlan)
+addCall call (CallPlan n calls)
+  | all earlier (resultsUsed call) = (n, CallPlan (n + 1) (call : calls))
+  | otherwise = error $ "[addCall] " ++ callMethod call
+                        ++ ": uses the result of a call not before it"
+  where
+    earlier j = j >= 0 && j < n
+    resultsUsed c = [ j | TargetResultOf j <- [callTarget c] ]
+                    ++ [ j | ArgumentResultOf j <- callArguments c ]
+
+-- |Execute the calls of a plan in order, stopping at the first exception.
+executeCallPlan :: CallPlan -> IO CallPlanResult
+executeCallPlan (CallPlan nCalls rcalls) = do
+  let calls = reverse rcalls
+  results <- mapM (mallocForeignPtrBytes . max 1 . callResultSize) calls
+  withMany withForeignPtr results $ \ pResults -> do
+    let resultPtrs = IntMap.fromList (zip [0..] pResults)
+    withMany withCString (map callMethod calls) $ \ methods ->
+      withMany (withArguments resultPtrs) (map callArguments calls) $ \ pArgs ->
+        allocaBytes (nCalls * cHsunoCallPlanStructSize) $ \ pCalls -> do
+          sequence_
+            [ setCall pCalls i call pResult method pArg
+            | (i, call, pResult, (method, pArg))
+                <- zip4 [0..] calls pResults (zip methods pArgs) ]
+          pException <- mallocBytes anyStructSize
+          done <- fromIntegral <$>
+            cHsunoExecuteCallPlan pCalls (fromIntegral nCalls) pException
+          if done < nCalls
+            then do
+              fpException <- FC.newForeignPtr pException
+                (anyDestruct pException nullFunPtr >> free pException)
+              -- the slots of the failed call and the ones after it were
+              -- never written
+              return (CallPlanResult (take done results)
+                                     (Just (done, fpException)))
+            else do
+              free pException
+              return (CallPlanResult results Nothing)
+  where
+    withArguments resultPtrs args f =
+      withArray (map (argumentPtr resultPtrs) args) f
+    argumentPtr _ (ArgumentPtr p) = p
+    argumentPtr resultPtrs (ArgumentResultOf j) = resultPtrs IntMap.! j
+    setCall pCalls i call pResult method pArg =
+      case callTarget call of
+        TargetInterface p -> set p (-1)
+        TargetResultOf j  -> set nullPtr (fromIntegral j)
+      where
+        pResult' = if callResultSize call == 0 then nullPtr else pResult
+        set p from = cHsunoCallPlanSet pCalls (fromIntegral i) p from method
+                                       pResult' pArg
+    zip4 (a:as) (b:bs) (c:cs) (d:ds) = (a, b, c, d) : zip4 as bs cs ds
+    zip4 _ _ _ _ = []
+
+data CPlannedCall
+
+foreign import ccall unsafe "hsunoCallPlan_structSize" cHsunoCallPlanStructSize
+  :: Int
+
+foreign import ccall unsafe "hsunoCallPlan_set" cHsunoCallPlanSet
+  :: Ptr CPlannedCall -> Int32 -> Ptr UnoInterface -> Int32 -> CString
+  -> Ptr () -> Ptr (Ptr ()) -> IO ()
+
+foreign import ccall "hsunoExecuteCallPlan" cHsunoExecuteCallPlan
+  :: Ptr CPlannedCall -> Int32 -> Ptr Any -> IO Int32
+
 -- *Auxiliary Functions
 
 withStringsArray :: [String] -> (Ptr CString -> IO a) -> IO a
@@ -2,6 +2,7 @@
 #define HSUNO_UNO_BINARY_H
 
 #include "com/sun/star/uno/XComponentContext.hpp"
+#include "typelib/typedescription.h"
 #include "uno/any2.h"
 #include "uno/mapping.hxx"
 
@@ -10,10 +11,34 @@
 
 using ::com::sun::star::uno::Exception;
 
+/** Query an interface of an object for Haskell.
+ *
+ * The result is counted by the accounting as acquired.
+ */
 extern "C"
 uno_Interface * hsunoQueryInterface (uno_Interface * iface,
     typelib_TypeDescriptionReference * pType);
 
+/** Query an interface of an object for the runtime's own use.
+ *
+ * Unlike hsunoQueryInterface the result is not counted, so it must be
+ * released without going through the accounting.
+ */
+extern "C"
+uno_Interface * hsunoQueryInterfaceUncounted (uno_Interface * iface,
+    typelib_TypeDescriptionReference * pType);
+
+/** Query several interfaces of an object in one call.
+ *
+ * ppResults[i] is set to the interface of type ppTypes[i], or 0 if the
+ * object does not implement it.
+ */
+extern "C"
+void hsunoQueryInterfaces (uno_Interface * iface, sal_Int32 nTypes,
+    typelib_TypeDescriptionReference ** ppTypes, uno_Interface ** ppResults);
+
+/** Like hsunoQueryInterfaceUncounted, with the type given by its name.
+ */
 extern "C"
 uno_Interface * hsunoQueryInterfaceByName (uno_Interface * iface,
     rtl_uString * psName);
@@ -26,11 +51,118 @@ extern "C"
 uno_Interface * hsunoCreateInstanceWithContextFromAscii (
     const char * sServiceSpecifier, uno_Interface * pContext);
 
+/** Drop the cache of a context.
+ *
+ * The cache holds the context's service manager, the component factories
+ * and the singletons obtained through it, and keeps the context alive.
+ */
+extern "C"
+void hsunoContextCacheRevoke (uno_Interface * pContext);
+
+/** Call a method on a binary UNO interface.
+ *
+ * The method type description is cached by the address of methodType, so it
+ * must point to a string with static storage duration (as in the generated
+ * stubs).  The result is not counted by the accounting; the generated stubs
+ * count what they hand over to Haskell.
+ */
 extern "C"
 void makeBinaryUnoCall(
     uno_Interface * interface, char const * methodType, void * result,
     void ** arguments, uno_Any ** exception);
 
+/** Resolved member descriptions of an interface type.
+ *
+ * The direct members of the interface (attributes first, then methods, in
+ * declaration order) start at nFirstDirectMember.
+ */
+struct HsunoInterfaceMembers {
+    sal_Int32 nFirstDirectMember;
+    sal_Int32 nAllMembers;
+    typelib_TypeDescription ** ppAllMembers;
+};
+
+/** Resolve all member descriptions of an interface type.
+ *
+ * The result is never freed; generated stubs keep it in a function-local
+ * static.  Returns 0 if the type registry has no such interface.
+ */
+extern "C"
+HsunoInterfaceMembers const * hsunoGetInterfaceMembers (
+    char const * interfaceType);
+
+/** Call a direct member of an interface by its position.
+ *
+ * position is relative to the first direct member of the interface.  If
+ * members is 0 (an unknown interface), the call raises a RuntimeException.
+ */
+extern "C"
+void makeBinaryUnoCallByPosition(
+    uno_Interface * interface, HsunoInterfaceMembers const * members,
+    sal_Int32 position, void * result, void ** arguments,
+    uno_Any ** exception);
+
+/** Retrieve the cached type description of a method ("Iface::method").
+ *
+ * The lookup is keyed by the address of methodType and is lock-free once the
+ * entry is present.  The description is owned by the cache.
+ */
+extern "C"
+typelib_TypeDescription * hsunoGetMethodDescription (char const * methodType);
+
+/** Like hsunoGetMethodDescription, but keyed by the contents of methodType.
+ *
+ * Use this for method names without static storage duration.
+ */
+extern "C"
+typelib_TypeDescription * hsunoGetMethodDescriptionByName (
+    char const * methodType);
+
+/** Load the type descriptions of the given methods into the by-name cache.
+ *
+ * The lock-free table is keyed by the addresses of the names at the call
+ * sites, which are not known here, so it is not seeded: the first call at
+ * each call site still takes the cache mutex once to publish its entry, but
+ * no longer looks the method up in the typelib.
+ */
+extern "C"
+void hsunoPrewarmMethodCache (char const ** methodTypes, sal_Int32 nMethodTypes);
+
+/** Call Plans
+ *
+ * A call plan is a sequence of calls executed in one go.  A call either has
+ * its target interface given or takes it from the (interface) result of an
+ * earlier call.  Arguments may point to the result slots of earlier calls.
+ */
+
+struct HsunoPlannedCall {
+    // target interface, or 0 to use the result of call nInterfaceFrom
+    uno_Interface * pInterface;
+    sal_Int32 nInterfaceFrom;
+    // "Iface::method"
+    char const * pMethodType;
+    void * pResult;
+    void ** ppArguments;
+};
+
+extern "C"
+int hsunoCallPlan_structSize ();
+
+extern "C"
+void hsunoCallPlan_set (HsunoPlannedCall * pCalls, sal_Int32 nCall,
+    uno_Interface * pInterface, sal_Int32 nInterfaceFrom,
+    char const * pMethodType, void * pResult, void ** ppArguments);
+
+/** Execute the calls of a plan in order, stopping at the first exception.
+ *
+ * Returns the number of calls completed.  When it is less than nCalls,
+ * pException is constructed with the exception raised (void if the target
+ * of the failing call was a null reference).
+ */
+extern "C"
+sal_Int32 hsunoExecuteCallPlan (HsunoPlannedCall const * pCalls,
+    sal_Int32 nCalls, uno_Any * pException);
+
 /** UNO Any Functions */
 
 #ifdef __cplusplus
@@ -55,14 +187,79 @@ rtl_uString * hsuno_any_getTypeName (uno_Any * pAny);
  */
 void * hsuno_any_getValue (uno_Any * pAny);
 
+/** Retrieve the message of the exception contained within the Any.
+ *
+ * The string is owned by the Any.
+ */
+rtl_uString * hsuno_any_getExceptionMessage (uno_Any * pAny);
+
+/** Constructs an Any, like uno_any_construct, counting it.
+ */
+void hsuno_any_construct (uno_Any * pAny, void * pData,
+    typelib_TypeDescription * pTypeDescr, uno_AcquireFunc acquire);
+
+/** Constructs an Any of a boolean, char or integral type class.
+ *
+ * The value is narrowed to the type class, and the static type reference of
+ * the type class is used, so no type description has to be looked up.
+ */
+void hsuno_any_constructInteger (uno_Any * pAny, int typeClass,
+    sal_Int64 value);
+
+/** Constructs an Any of an enum type, given by its type description.
+ */
+void hsuno_any_constructEnum (uno_Any * pAny, typelib_TypeDescription * pType,
+    sal_Int32 value);
+
+/** Constructs an Any of type float.
+ */
+void hsuno_any_constructFloat (uno_Any * pAny, float value);
+
+/** Constructs an Any of type double.
+ */
+void hsuno_any_constructDouble (uno_Any * pAny, double value);
+
 /** Destroys an Any, releasing the interface it contains if any.
  */
 void hsuno_any_destruct (uno_Any * pAny, uno_ReleaseFunc release);
 
+/** Constructs an Any as a copy of another, sharing (acquiring) its value.
+ */
+void hsuno_any_copy (uno_Any * pDest, uno_Any const * pSource);
+
+/** Allocates an (unconstructed) Any on the heap, e.g. for a call result.
+ */
+uno_Any * hsuno_any_new ();
+
+/** Frees an Any allocated by hsuno_any_new, which must be destructed.
+ */
+void hsuno_any_delete (uno_Any * pAny);
+
+/** Destroys and frees an Any allocated by hsuno_any_new.
+ */
+void hsuno_any_free (uno_Any * pAny);
+
 #ifdef __cplusplus
 }
 #endif
 
+/** UNO Sequence Functions */
+
+/** Constructs a sequence of the given type, copying nElements elements.
+ *
+ * With pElements 0, the elements are default constructed.  Interface
+ * elements are acquired.
+ */
+extern "C"
+uno_Sequence * hsuno_sequence_construct (typelib_TypeDescription * pType,
+    void * pElements, sal_Int32 nElements);
+
+/** Sets an element of a sequence of strings, taking over the string.
+ */
+extern "C"
+void hsuno_sequence_adoptString (uno_Sequence * pSequence, sal_Int32 nIndex,
+    rtl_uString * pStr);
+
 // TODO clean the funtions below.
 
 extern "C"
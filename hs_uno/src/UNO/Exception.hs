@@ -0,0 +1,37 @@
+{-# LANGUAGE DeriveDataTypeable #-}
+module UNO.Exception
+  ( UnoException (..)
+  , throwUnoException
+  , throwIfUnoException
+  ) where
+
+import Control.Exception (Exception, throwIO)
+import Data.Text (Text)
+import Data.Typeable (Typeable)
+import Foreign
+
+import qualified UNO.Binary as B
+import UNO.Text
+
+-- |An exception raised by a UNO call.
+data UnoException = UnoException
+  { unoExceptionType    :: Text -- ^ the name of the exception type
+  , unoExceptionMessage :: Text
+  } deriving (Show, Typeable)
+
+instance Exception UnoException
+
+-- |Throw the UNO exception held by an Any, destructing the Any.
+throwUnoException :: Ptr B.Any -> IO a
+throwUnoException pException = do
+  name <- uStringToText =<< B.anyGetTypeName pException
+  message <- uStringToText =<< B.anyGetExceptionMessage pException
+  B.anyDestruct pException nullFunPtr
+  throwIO (UnoException name message)
+
+-- |Throw the exception left by a call, given the exception pointer as set by
+-- the call (null if it returned normally).
+throwIfUnoException :: Ptr B.Any -> IO ()
+throwIfUnoException pException
+  | pException == nullPtr = return ()
+  | otherwise             = throwUnoException pException
@@ -0,0 +1,70 @@
+module UNO.Executor
+  ( Executor
+  , Future
+  , newExecutor
+  , shutdownExecutor
+  , submit
+  , await
+  , poll
+  ) where
+
+import Control.Applicative ((<$>))
+import Control.Concurrent
+import Control.Exception
+import Control.Monad
+
+-- |Bound OS threads that run UNO calls on behalf of other threads.
+--
+-- Green threads submit calls and wait on 'Future's, so only the workers
+-- occupy OS threads while calls are in progress.  Requires the threaded
+-- runtime.
+data Executor = Executor
+  { executorQueue   :: Chan (Maybe (IO ()))
+  , executorWorkers :: [MVar ()]
+  }
+
+-- |The eventual result of a submitted call.
+newtype Future a = Future (MVar (Either SomeException a))
+
+-- |Start an executor with the given number of bound worker threads.
+newExecutor :: Int -> IO Executor
+newExecutor n = do
+  queue <- newChan
+  workers <- replicateM (max 1 n) $ do
+    done <- newEmptyMVar
+    _ <- forkOS (worker queue `finally` putMVar done ())
+    return done
+  return (Executor queue workers)
+  where
+    worker queue = do
+      job <- readChan queue
+      case job of
+        Nothing -> return ()
+        Just j  -> j >> worker queue
+
+-- |Stop the workers after the calls already submitted have run.
+shutdownExecutor :: Executor -> IO ()
+shutdownExecutor executor = do
+  replicateM_ (length (executorWorkers executor)) $
+    writeChan (executorQueue executor) Nothing
+  mapM_ takeMVar (executorWorkers executor)
+
+-- |Run a call on one of the executor's workers.
+submit :: Executor -> IO a -> IO (Future a)
+submit executor call = do
+  result <- newEmptyMVar
+  writeChan (executorQueue executor) $
+    Just (try call >>= putMVar result)
+  return (Future result)
+
+-- |Wait for the result of a call, rethrowing its exception if it failed.
+await :: Future a -> IO a
+await (Future result) = readMVar result >>= either throwIO return
+
+-- |The result of a call, if it has finished.
+poll :: Future a -> IO (Maybe a)
+poll (Future result) = do
+  r <- tryReadMVar result
+  case r of
+    Nothing -> return Nothing
+    Just v  -> Just <$> either throwIO return v
@@ -0,0 +1,223 @@
+#include "Invoke.hxx"
+#include "Accounting.hxx"
+#include "Binary.hxx"
+
+#include "osl/mutex.hxx"
+#include "rtl/ustring.hxx"
+#include "typelib/typedescription.h"
+#include "uno/data.h"
+
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct InvokeParameter {
+  typelib_TypeDescription * pType;
+  // of the slot of the argument in the argument buffer
+  sal_Int32 nOffset;
+  bool bIn;
+  bool bOut;
+};
+
+// How to call a method: the type descriptions of its parameters and return
+// value and where their slots are in one argument buffer.
+struct InvokePlan {
+  typelib_TypeDescription * pMethod;
+  typelib_TypeDescriptionReference * pInterfaceType;
+  std::vector< InvokeParameter > parameters;
+  // 0 for void methods
+  typelib_TypeDescription * pReturnType;
+  sal_Int32 nReturnOffset;
+  sal_Int32 nBufferSize;
+};
+
+// Reserve an aligned slot for a value of the given type in a buffer of
+// nSize bytes.
+sal_Int32 reserveSlot (sal_Int32 & nSize, typelib_TypeDescription const * pTD)
+{
+  sal_Int32 nAlignment = pTD->nAlignment > 0 ? pTD->nAlignment : 1;
+  sal_Int32 nOffset = (nSize + nAlignment - 1) / nAlignment * nAlignment;
+  nSize = nOffset + (pTD->nSize > 0 ? pTD->nSize : 1);
+  return nOffset;
+}
+
+// The plan of a method given by its qualified name, or 0 if there is no such
+// interface method.
+InvokePlan * compilePlan (rtl::OUString const & sMethod)
+{
+  sal_Int32 nSeparator = sMethod.indexOf("::");
+  if (nSeparator <= 0)
+    return 0;
+  typelib_TypeDescription * pMethod = 0;
+  typelib_typedescription_getByName(&pMethod, sMethod.pData);
+  if (pMethod == 0)
+    return 0;
+  if (pMethod->eTypeClass != typelib_TypeClass_INTERFACE_METHOD) {
+    typelib_typedescription_release(pMethod);
+    return 0;
+  }
+  typelib_InterfaceMethodTypeDescription const * pMethodTD =
+    reinterpret_cast< typelib_InterfaceMethodTypeDescription const * >(
+        pMethod);
+
+  InvokePlan * plan = new InvokePlan;
+  plan->pMethod = pMethod;
+  plan->pInterfaceType = 0;
+  rtl::OUString sInterface (sMethod.copy(0, nSeparator));
+  typelib_typedescriptionreference_new(&plan->pInterfaceType,
+      typelib_TypeClass_INTERFACE, sInterface.pData);
+  sal_Int32 nSize = 0;
+  plan->parameters.reserve(pMethodTD->nParams);
+  for (sal_Int32 i = 0 ; i < pMethodTD->nParams ; ++i) {
+    typelib_MethodParameter const & p (pMethodTD->pParams[i]);
+    InvokeParameter parameter;
+    parameter.pType = 0;
+    typelib_typedescriptionreference_getDescription(&parameter.pType,
+        p.pTypeRef);
+    assert(parameter.pType != 0);
+    parameter.nOffset = reserveSlot(nSize, parameter.pType);
+    parameter.bIn = p.bIn;
+    parameter.bOut = p.bOut;
+    plan->parameters.push_back(parameter);
+  }
+  plan->pReturnType = 0;
+  plan->nReturnOffset = 0;
+  if (pMethodTD->pReturnTypeRef->eTypeClass != typelib_TypeClass_VOID) {
+    typelib_typedescriptionreference_getDescription(&plan->pReturnType,
+        pMethodTD->pReturnTypeRef);
+    assert(plan->pReturnType != 0);
+    plan->nReturnOffset = reserveSlot(nSize, plan->pReturnType);
+  }
+  plan->nBufferSize = nSize;
+  return plan;
+}
+
+typedef std::unordered_map< rtl::OUString, InvokePlan const *,
+        rtl::OUStringHash > InvokePlans;
+
+osl::Mutex & invokePlansMutex () {
+  static osl::Mutex mutex;
+  return mutex;
+}
+
+// must be called with invokePlansMutex locked; the plans are never freed
+InvokePlans & invokePlans () {
+  static InvokePlans * plans = new InvokePlans;
+  return *plans;
+}
+
+InvokePlan const * getPlan (rtl_uString * pMethod)
+{
+  rtl::OUString sMethod (pMethod);
+  osl::MutexGuard guard (invokePlansMutex());
+  InvokePlans & plans (invokePlans());
+  InvokePlans::const_iterator it (plans.find(sMethod));
+  if (it != plans.end())
+    return it->second;
+  InvokePlan const * plan = compilePlan(sMethod);
+  // unknown methods are not remembered
+  if (plan != 0)
+    plans[sMethod] = plan;
+  return plan;
+}
+
+// Interfaces queried while converting arguments are owned by the argument
+// slots and released by uno_destructData, so they are not counted.
+void * SAL_CALL queryArgumentInterface (void * pInterface,
+    typelib_TypeDescriptionReference * pType)
+{
+  return hsunoQueryInterfaceUncounted(
+      static_cast< uno_Interface * >(pInterface), pType);
+}
+
+void releaseInterface (uno_Interface * pInterface) {
+  if (pInterface != 0)
+    (*pInterface->release)(pInterface);
+}
+
+// Argument buffers and slot pointers of methods with few parameters are kept
+// on the stack.
+const std::size_t localBufferSize = 256;
+const std::size_t localArguments = 16;
+
+} // anonymous namespace
+
+extern "C"
+sal_Int32 hsuno_invoke (uno_Interface * pIface, rtl_uString * pMethod,
+    sal_Int32 nArguments, uno_Any * pArguments, uno_Any * pResult,
+    uno_Any * pException, sal_Int32 * pBadArgument)
+{
+  InvokePlan const * plan = getPlan(pMethod);
+  if (plan == 0)
+    return HSUNO_INVOKE_UNKNOWN_METHOD;
+  sal_Int32 nParameters = static_cast< sal_Int32 >(plan->parameters.size());
+  if (nArguments != nParameters)
+    return HSUNO_INVOKE_ARGUMENT_COUNT;
+  uno_Interface * pTarget =
+    hsunoQueryInterfaceUncounted(pIface, plan->pInterfaceType);
+  if (pTarget == 0)
+    return HSUNO_INVOKE_NOT_IMPLEMENTED;
+
+  double localBuffer [localBufferSize / sizeof (double)];
+  std::vector< double > heapBuffer;
+  char * pBuffer = reinterpret_cast< char * >(localBuffer);
+  if (static_cast< std::size_t >(plan->nBufferSize) > sizeof localBuffer) {
+    heapBuffer.resize(plan->nBufferSize / sizeof (double) + 1);
+    pBuffer = reinterpret_cast< char * >(&heapBuffer[0]);
+  }
+  void * localSlots [localArguments];
+  std::vector< void * > heapSlots;
+  void ** ppSlots = localSlots;
+  if (static_cast< std::size_t >(nParameters) > localArguments) {
+    heapSlots.resize(nParameters);
+    ppSlots = &heapSlots[0];
+  }
+
+  // pure out parameters are left uninitialized for the callee
+  for (sal_Int32 i = 0 ; i < nParameters ; ++i) {
+    InvokeParameter const & p (plan->parameters[i]);
+    ppSlots[i] = pBuffer + p.nOffset;
+    if (!p.bIn)
+      continue;
+    uno_constructData(ppSlots[i], p.pType);
+    if (!uno_type_assignData(ppSlots[i], p.pType->pWeakRef,
+          pArguments[i].pData, pArguments[i].pType, queryArgumentInterface,
+          0, 0)) {
+      for (sal_Int32 j = 0 ; j <= i ; ++j)
+        if (plan->parameters[j].bIn)
+          uno_destructData(ppSlots[j], plan->parameters[j].pType, 0);
+      releaseInterface(pTarget);
+      *pBadArgument = i;
+      return HSUNO_INVOKE_ARGUMENT_TYPE;
+    }
+  }
+
+  void * pReturn = plan->pReturnType != 0 ? pBuffer + plan->nReturnOffset : 0;
+  uno_Any * pExc = pException;
+  (*pTarget->pDispatcher)(pTarget, plan->pMethod, pReturn, ppSlots, &pExc);
+  releaseInterface(pTarget);
+
+  // on an exception out parameters are not constructed, and in/out
+  // parameters keep their values
+  bool bException = pExc != 0;
+  for (sal_Int32 i = 0 ; i < nParameters ; ++i) {
+    InvokeParameter const & p (plan->parameters[i]);
+    if (p.bIn || !bException)
+      uno_destructData(ppSlots[i], p.pType, 0);
+  }
+  if (bException) {
+    hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+    return HSUNO_INVOKE_EXCEPTION;
+  }
+
+  if (pReturn != 0) {
+    uno_any_construct(pResult, pReturn, plan->pReturnType, 0);
+    uno_destructData(pReturn, plan->pReturnType, 0);
+  } else {
+    uno_any_construct(pResult, 0, 0, 0);
+  }
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  return HSUNO_INVOKE_OK;
+}
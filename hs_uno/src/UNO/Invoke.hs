@@ -0,0 +1,57 @@
+module UNO.Invoke
+  ( invoke
+  ) where
+
+import Data.Text (Text, unpack)
+import Foreign
+
+import UNO.Any
+import qualified UNO.Binary as B
+import UNO.Exception
+import UNO.Reference
+import UNO.Text
+
+-- |Call a method of an object that is only known at run time, given by its
+-- qualified name (as in "com.sun.star.frame.XDesktop::terminate").
+--
+-- The arguments are converted to the parameter types as in the C++ binding
+-- (integral types are widened, interfaces are queried).  The values of out
+-- parameters are discarded.  A void method returns 'AVoid'.
+--
+-- The types of a method are looked up on its first call and kept, so that
+-- later calls only convert the arguments.
+invoke :: Reference a -> Text -> [Any] -> IO Any
+invoke r method args = do
+  let n = length args
+  withReference r $ \ pIface ->
+    withUStringArg method $ \ pMethod ->
+      allocaBytes (n * B.anyStructSize) $ \ pArgs ->
+        allocaBytes B.anyStructSize $ \ pResult ->
+          allocaBytes B.anyStructSize $ \ pException ->
+            alloca $ \ pBadArgument -> do
+              status <- withAnyArray args pArgs $
+                cHsunoInvoke (castPtr pIface) pMethod (fromIntegral n) pArgs
+                  pResult pException pBadArgument
+              case status of
+                0 -> do
+                  v <- anyFromUno pResult
+                  B.anyDestruct pResult nullFunPtr
+                  return v
+                1 -> throwUnoException pException
+                2 -> invokeError "unknown interface method"
+                3 -> invokeError $ "wrong number of arguments ("
+                                   ++ show n ++ ")"
+                4 -> invokeError "the object does not implement the interface"
+                5 -> do
+                  i <- peek pBadArgument
+                  invokeError $ "argument " ++ show i
+                                ++ " does not match the parameter type"
+                _ -> invokeError "unexpected status"
+  where
+    invokeError msg = error $ "[invoke] " ++ unpack method ++ ": " ++ msg
+
+-- *Foreign imports
+
+foreign import ccall "hsuno_invoke" cHsunoInvoke
+  :: Ptr () -> Ptr UString -> Int32 -> Ptr B.Any -> Ptr B.Any -> Ptr B.Any
+  -> Ptr Int32 -> IO Int32
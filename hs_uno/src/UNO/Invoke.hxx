@@ -0,0 +1,44 @@
+#ifndef HSUNO_UNO_INVOKE_H
+#define HSUNO_UNO_INVOKE_H
+
+#include "rtl/ustring.h"
+#include "uno/any2.h"
+
+/** Dynamic Invocation
+ *
+ * Calls of methods that are only known at run time, given by their qualified
+ * name ("com.sun.star.frame.XDesktop::terminate") and with their arguments
+ * in Anys.  The parameter and return types of a method are looked up once
+ * and kept, with the layout of its argument slots, for the lifetime of the
+ * process.
+ */
+
+enum HsunoInvokeStatus {
+    HSUNO_INVOKE_OK,
+    // the method threw; pException holds the exception
+    HSUNO_INVOKE_EXCEPTION,
+    // there is no interface method of that name
+    HSUNO_INVOKE_UNKNOWN_METHOD,
+    // the number of arguments is not the number of parameters
+    HSUNO_INVOKE_ARGUMENT_COUNT,
+    // the object does not implement the interface of the method
+    HSUNO_INVOKE_NOT_IMPLEMENTED,
+    // an argument cannot be converted to its parameter type; pBadArgument
+    // holds its index
+    HSUNO_INVOKE_ARGUMENT_TYPE
+};
+
+/** Call a method of an object.
+ *
+ * The arguments are converted like assignments in the C++ binding: integral
+ * types are widened and interfaces are queried.  The values of out
+ * parameters are discarded.  On HSUNO_INVOKE_OK pResult holds the return
+ * value (a void Any for void methods); otherwise it is left uninitialized.
+ * The arguments are not modified.
+ */
+extern "C"
+sal_Int32 hsuno_invoke (uno_Interface * pIface, rtl_uString * pMethod,
+    sal_Int32 nArguments, uno_Any * pArguments, uno_Any * pResult,
+    uno_Any * pException, sal_Int32 * pBadArgument);
+
+#endif // HSUNO_UNO_INVOKE_H
@@ -0,0 +1,410 @@
+#include "Property.hxx"
+#include "Accounting.hxx"
+#include "Binary.hxx"
+
+#include "osl/mutex.hxx"
+#include "rtl/ustring.hxx"
+#include "typelib/typedescription.h"
+#include "uno/data.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// The interfaces and values of the calls made here are not counted by the
+// accounting, except for the values and exceptions handed over to Haskell.
+
+namespace {
+
+typedef std::unordered_map< rtl::OUString, sal_Int32, rtl::OUStringHash >
+  PropertyHandles;
+typedef std::shared_ptr< PropertyHandles const > PropertyHandlesRef;
+
+void releaseInterface (uno_Interface * pInterface) {
+  if (pInterface != 0)
+    (*pInterface->release)(pInterface);
+}
+
+uno_Interface * queryInterface (uno_Interface * pInterface, char const * type)
+{
+  rtl::OUString sType (rtl::OUString::createFromAscii(type));
+  return hsunoQueryInterfaceByName(pInterface, sType.pData);
+}
+
+// The XPropertySetInfo of an object, or 0 if it has none.
+uno_Interface * propertySetInfo (uno_Interface * xPropertySet)
+{
+  uno_Any exception;
+  uno_Any * pException = &exception;
+  uno_Interface * xInfo = 0;
+  makeBinaryUnoCall(xPropertySet,
+      "com.sun.star.beans.XPropertySet::getPropertySetInfo", &xInfo, NULL,
+      &pException);
+  if (pException != 0) {
+    uno_any_destruct(pException, 0);
+    return 0;
+  }
+  return xInfo;
+}
+
+// Read the handles of all properties from an XPropertySetInfo.
+void readPropertyHandles (uno_Interface * xInfo, PropertyHandles & handles)
+{
+  uno_Any exception;
+  uno_Any * pException = &exception;
+  uno_Sequence * pProperties = 0;
+  makeBinaryUnoCall(xInfo, "com.sun.star.beans.XPropertySetInfo::getProperties",
+      &pProperties, NULL, &pException);
+  if (pException != 0) {
+    uno_any_destruct(pException, 0);
+    return;
+  }
+
+  // the Name and Handle members of com.sun.star.beans.Property
+  typelib_TypeDescription * pPropertyTD = 0;
+  rtl::OUString sProperty ("com.sun.star.beans.Property");
+  typelib_typedescription_getByName(&pPropertyTD, sProperty.pData);
+  assert(pPropertyTD != 0);
+  typelib_CompoundTypeDescription * pCompoundTD =
+    reinterpret_cast< typelib_CompoundTypeDescription * >(pPropertyTD);
+  sal_Int32 nNameOffset = -1;
+  sal_Int32 nHandleOffset = -1;
+  for (sal_Int32 i = 0 ; i < pCompoundTD->nMembers ; ++i) {
+    rtl::OUString sMember (pCompoundTD->ppMemberNames[i]);
+    if (sMember == "Name")
+      nNameOffset = pCompoundTD->pMemberOffsets[i];
+    else if (sMember == "Handle")
+      nHandleOffset = pCompoundTD->pMemberOffsets[i];
+  }
+  assert(nNameOffset >= 0 && nHandleOffset >= 0);
+
+  for (sal_Int32 i = 0 ; i < pProperties->nElements ; ++i) {
+    char const * pElement = pProperties->elements + i * pPropertyTD->nSize;
+    rtl::OUString sName (
+        *reinterpret_cast< rtl_uString * const * >(pElement + nNameOffset));
+    handles[sName] =
+      *reinterpret_cast< sal_Int32 const * >(pElement + nHandleOffset);
+  }
+  typelib_typedescription_release(pPropertyTD);
+
+  typelib_TypeDescription * pSequenceTD = 0;
+  rtl::OUString sSequence ("[]com.sun.star.beans.Property");
+  typelib_typedescription_getByName(&pSequenceTD, sSequence.pData);
+  assert(pSequenceTD != 0);
+  uno_destructData(&pProperties, pSequenceTD, 0);
+  typelib_typedescription_release(pSequenceTD);
+}
+
+// The type description of a sequence type, kept for the lifetime of the
+// process.
+typelib_TypeDescription * sequenceDescription (char const * type)
+{
+  rtl::OUString sType (rtl::OUString::createFromAscii(type));
+  typelib_TypeDescription * pTD = 0;
+  typelib_typedescription_getByName(&pTD, sType.pData);
+  assert(pTD != 0);
+  return pTD;
+}
+
+// Handle tables by XPropertySetInfo.  Implementations usually share one info
+// among their instances, so that the handles are read once per
+// implementation, while objects with property sets of their own get tables
+// of their own.  Each entry keeps its info alive, so that its pointer is not
+// reused; the cache is emptied when it is full, and a table lives on as long
+// as a property access uses it.
+struct PropertyHandleTables {
+  osl::Mutex mutex;
+  std::unordered_map< uno_Interface *, PropertyHandlesRef > tables;
+};
+
+std::size_t const nMaxPropertyHandleTables = 256;
+
+// never destroyed, as the infos cannot be released at exit
+PropertyHandleTables & propertyHandleTables () {
+  static PropertyHandleTables * tables = new PropertyHandleTables;
+  return *tables;
+}
+
+} // anonymous namespace
+
+class HsunoPropertyAccess {
+  public:
+    explicit HsunoPropertyAccess (uno_Interface * xPropertySet);
+    ~HsunoPropertyAccess ();
+    bool get (rtl_uString * pName, uno_Any * pResult, uno_Any * pException);
+    bool set (rtl_uString * pName, uno_Any * pValue, uno_Any * pException);
+  private:
+    sal_Int32 findHandle (rtl_uString * pName);
+
+    uno_Interface * xPropertySet;
+    // 0 when the object does not implement XFastPropertySet
+    uno_Interface * xFastPropertySet;
+    PropertyHandlesRef pHandles;
+    // the handles looked up so far, by name pointer: the names passed from
+    // Haskell are interned and never freed, so the pointer identifies the
+    // name without hashing it
+    std::mutex mutex;
+    std::unordered_map< rtl_uString *, sal_Int32 > resolvedHandles;
+};
+
+HsunoPropertyAccess::HsunoPropertyAccess (uno_Interface * xPropertySet)
+  : xPropertySet(xPropertySet), xFastPropertySet(0)
+{
+  xFastPropertySet =
+    queryInterface(xPropertySet, "com.sun.star.beans.XFastPropertySet");
+  if (xFastPropertySet == 0)
+    return;
+  uno_Interface * xInfo = propertySetInfo(xPropertySet);
+  if (xInfo == 0)
+    return;
+  PropertyHandleTables & cache (propertyHandleTables());
+  {
+    osl::MutexGuard guard (cache.mutex);
+    auto it = cache.tables.find(xInfo);
+    if (it != cache.tables.end()) {
+      pHandles = it->second;
+      releaseInterface(xInfo);
+      return;
+    }
+  }
+  // the handles are read without the lock held, as this may be a remote
+  // call; the first table stored for an info wins
+  std::shared_ptr< PropertyHandles > pNewHandles (new PropertyHandles);
+  readPropertyHandles(xInfo, *pNewHandles);
+  std::unordered_map< uno_Interface *, PropertyHandlesRef > evicted;
+  bool bInserted;
+  {
+    osl::MutexGuard guard (cache.mutex);
+    if (cache.tables.size() >= nMaxPropertyHandleTables)
+      cache.tables.swap(evicted);
+    auto inserted = cache.tables.insert(std::make_pair(xInfo,
+          PropertyHandlesRef(pNewHandles)));
+    bInserted = inserted.second;
+    pHandles = inserted.first->second;
+  }
+  // the reference to the info is kept by the cache entry
+  if (!bInserted)
+    releaseInterface(xInfo);
+  for (auto & table : evicted)
+    releaseInterface(table.first);
+}
+
+HsunoPropertyAccess::~HsunoPropertyAccess () {
+  releaseInterface(xFastPropertySet);
+  releaseInterface(xPropertySet);
+}
+
+sal_Int32 HsunoPropertyAccess::findHandle (rtl_uString * pName) {
+  if (!pHandles)
+    return -1;
+  std::lock_guard< std::mutex > lock (mutex);
+  auto resolved = resolvedHandles.find(pName);
+  if (resolved != resolvedHandles.end())
+    return resolved->second;
+  PropertyHandles::const_iterator it (pHandles->find(rtl::OUString(pName)));
+  sal_Int32 nHandle = it == pHandles->end() ? -1 : it->second;
+  resolvedHandles.insert(std::make_pair(pName, nHandle));
+  return nHandle;
+}
+
+bool HsunoPropertyAccess::get (rtl_uString * pName, uno_Any * pResult,
+    uno_Any * pException)
+{
+  uno_Any * pExc = pException;
+  sal_Int32 nHandle = findHandle(pName);
+  if (nHandle != -1) {
+    void * arguments [1];
+    arguments[0] = &nHandle;
+    makeBinaryUnoCall(xFastPropertySet,
+        "com.sun.star.beans.XFastPropertySet::getFastPropertyValue", pResult,
+        arguments, &pExc);
+  } else {
+    void * arguments [1];
+    arguments[0] = &pName;
+    makeBinaryUnoCall(xPropertySet,
+        "com.sun.star.beans.XPropertySet::getPropertyValue", pResult,
+        arguments, &pExc);
+  }
+  // either the value or the exception
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  return pExc == 0;
+}
+
+bool HsunoPropertyAccess::set (rtl_uString * pName, uno_Any * pValue,
+    uno_Any * pException)
+{
+  uno_Any * pExc = pException;
+  sal_Int32 nHandle = findHandle(pName);
+  if (nHandle != -1) {
+    void * arguments [2];
+    arguments[0] = &nHandle;
+    arguments[1] = pValue;
+    makeBinaryUnoCall(xFastPropertySet,
+        "com.sun.star.beans.XFastPropertySet::setFastPropertyValue", NULL,
+        arguments, &pExc);
+  } else {
+    void * arguments [2];
+    arguments[0] = &pName;
+    arguments[1] = pValue;
+    makeBinaryUnoCall(xPropertySet,
+        "com.sun.star.beans.XPropertySet::setPropertyValue", NULL,
+        arguments, &pExc);
+  }
+  if (pExc != 0)
+    hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  return pExc == 0;
+}
+
+extern "C"
+HsunoPropertyAccess * hsuno_properties_new (uno_Interface * pIface)
+{
+  uno_Interface * xPropertySet =
+    queryInterface(pIface, "com.sun.star.beans.XPropertySet");
+  if (xPropertySet == 0)
+    return 0;
+  return new HsunoPropertyAccess(xPropertySet);
+}
+
+extern "C"
+void hsuno_properties_delete (HsunoPropertyAccess * pAccess)
+{
+  delete pAccess;
+}
+
+extern "C"
+sal_Bool hsuno_properties_get (HsunoPropertyAccess * pAccess,
+    rtl_uString * pName, uno_Any * pResult, uno_Any * pException)
+{
+  return pAccess->get(pName, pResult, pException);
+}
+
+extern "C"
+sal_Bool hsuno_properties_set (HsunoPropertyAccess * pAccess,
+    rtl_uString * pName, uno_Any * pValue, uno_Any * pException)
+{
+  return pAccess->set(pName, pValue, pException);
+}
+
+// Batches
+
+extern "C"
+sal_Int32 hsuno_properties_setValues (uno_Interface * pIface,
+    sal_Int32 nProperties, rtl_uString ** ppNames, uno_Any * pValues,
+    uno_Any * pException)
+{
+  uno_Any * pExc = pException;
+  uno_Interface * xMultiPropertySet =
+    queryInterface(pIface, "com.sun.star.beans.XMultiPropertySet");
+  if (xMultiPropertySet != 0) {
+    static typelib_TypeDescription * pNamesTD = sequenceDescription("[]string");
+    static typelib_TypeDescription * pValuesTD = sequenceDescription("[]any");
+    // each sequence is made in one go from the arrays of the batch
+    uno_Sequence * pNames = 0;
+    uno_Sequence * pValueSequence = 0;
+    uno_sequence_construct(&pNames, pNamesTD, ppNames, nProperties, 0);
+    uno_sequence_construct(&pValueSequence, pValuesTD, pValues, nProperties,
+        0);
+    void * arguments [2];
+    arguments[0] = &pNames;
+    arguments[1] = &pValueSequence;
+    makeBinaryUnoCall(xMultiPropertySet,
+        "com.sun.star.beans.XMultiPropertySet::setPropertyValues", NULL,
+        arguments, &pExc);
+    uno_destructData(&pValueSequence, pValuesTD, 0);
+    uno_destructData(&pNames, pNamesTD, 0);
+    releaseInterface(xMultiPropertySet);
+    if (pExc != 0) {
+      hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+      return HSUNO_PROPERTIES_EXCEPTION;
+    }
+    return HSUNO_PROPERTIES_OK;
+  }
+
+  // one call per property, up to the first that fails
+  pExc = 0;
+  uno_Interface * xPropertySet =
+    queryInterface(pIface, "com.sun.star.beans.XPropertySet");
+  if (xPropertySet == 0)
+    return HSUNO_PROPERTIES_NOT_SUPPORTED;
+  for (sal_Int32 i = 0 ; i < nProperties && pExc == 0 ; ++i) {
+    pExc = pException;
+    void * arguments [2];
+    arguments[0] = &ppNames[i];
+    arguments[1] = &pValues[i];
+    makeBinaryUnoCall(xPropertySet,
+        "com.sun.star.beans.XPropertySet::setPropertyValue", NULL,
+        arguments, &pExc);
+  }
+  releaseInterface(xPropertySet);
+  if (pExc != 0) {
+    hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+    return HSUNO_PROPERTIES_EXCEPTION;
+  }
+  return HSUNO_PROPERTIES_OK;
+}
+
+extern "C"
+sal_Int32 hsuno_properties_getValues (uno_Interface * pIface,
+    sal_Int32 nProperties, rtl_uString ** ppNames, uno_Any * pValues,
+    uno_Any * pException)
+{
+  uno_Any * pExc = pException;
+  uno_Interface * xMultiPropertySet =
+    queryInterface(pIface, "com.sun.star.beans.XMultiPropertySet");
+  if (xMultiPropertySet != 0) {
+    static typelib_TypeDescription * pNamesTD = sequenceDescription("[]string");
+    static typelib_TypeDescription * pValuesTD = sequenceDescription("[]any");
+    uno_Sequence * pNames = 0;
+    uno_sequence_construct(&pNames, pNamesTD, ppNames, nProperties, 0);
+    uno_Sequence * pValueSequence = 0;
+    void * arguments [1];
+    arguments[0] = &pNames;
+    makeBinaryUnoCall(xMultiPropertySet,
+        "com.sun.star.beans.XMultiPropertySet::getPropertyValues",
+        &pValueSequence, arguments, &pExc);
+    uno_destructData(&pNames, pNamesTD, 0);
+    releaseInterface(xMultiPropertySet);
+    if (pExc != 0) {
+      hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+      return HSUNO_PROPERTIES_EXCEPTION;
+    }
+    uno_Any const * pElements =
+      reinterpret_cast< uno_Any const * >(pValueSequence->elements);
+    assert(pValueSequence->nElements == nProperties);
+    for (sal_Int32 i = 0 ; i < nProperties ; ++i)
+      uno_type_any_construct(&pValues[i], pElements[i].pData,
+          pElements[i].pType, 0);
+    hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED, nProperties);
+    uno_destructData(&pValueSequence, pValuesTD, 0);
+    return HSUNO_PROPERTIES_OK;
+  }
+
+  // one call per property; the values already read are destructed again
+  // when one of the calls fails
+  uno_Interface * xPropertySet =
+    queryInterface(pIface, "com.sun.star.beans.XPropertySet");
+  if (xPropertySet == 0)
+    return HSUNO_PROPERTIES_NOT_SUPPORTED;
+  sal_Int32 i = 0;
+  for (; i < nProperties ; ++i) {
+    pExc = pException;
+    void * arguments [1];
+    arguments[0] = &ppNames[i];
+    makeBinaryUnoCall(xPropertySet,
+        "com.sun.star.beans.XPropertySet::getPropertyValue", &pValues[i],
+        arguments, &pExc);
+    if (pExc != 0)
+      break;
+  }
+  releaseInterface(xPropertySet);
+  if (pExc == 0) {
+    hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED, nProperties);
+    return HSUNO_PROPERTIES_OK;
+  }
+  while (i > 0)
+    uno_any_destruct(&pValues[--i], 0);
+  hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);
+  return HSUNO_PROPERTIES_EXCEPTION;
+}
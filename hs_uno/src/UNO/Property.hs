@@ -0,0 +1,200 @@
+module UNO.Property
+  ( PropertyAccess
+  , propertyAccess
+  , getProperty
+  , setProperty
+  , getPropertyUString
+  , setPropertyUString
+  , getPropertiesAtOnce
+  , setPropertiesAtOnce
+  , PropertyBatch
+  , withPropertyBatch
+  , batchSetProperty
+  , batchGetProperties
+  , flushPropertyBatch
+  ) where
+
+import Control.Applicative ((<$>))
+import Control.Monad (forM, unless, when)
+import Data.IORef
+import qualified Data.Map as Map
+import Data.Map (Map)
+import qualified Data.Set as Set
+import Data.Text (Text)
+import Foreign
+
+import UNO.Any
+import qualified UNO.Binary as B
+import UNO.Exception
+import UNO.Reference
+import UNO.Text
+
+-- *Property Access
+
+data CPropertyAccess
+
+-- |Property access to an object.
+--
+-- Properties are accessed by handle through XFastPropertySet when the object
+-- supports it; the handles are read once per XPropertySetInfo, which the
+-- objects of an implementation usually share, and each name is looked up
+-- once per access.
+newtype PropertyAccess = PropertyAccess (ForeignPtr CPropertyAccess)
+
+-- |Make the property access to an object implementing XPropertySet.
+propertyAccess :: Reference a -> IO PropertyAccess
+propertyAccess r = withReference r $ \ pIface -> do
+  pAccess <- cHsunoPropertiesNew (castPtr pIface)
+  when (pAccess == nullPtr) $
+    error "object does not implement com.sun.star.beans.XPropertySet"
+  PropertyAccess <$> newForeignPtr cHsunoPropertiesDeletePtr pAccess
+
+-- |Get a property by name.  The name is interned.
+getProperty :: Anyable a => PropertyAccess -> Text -> IO a
+getProperty p name = internUString name >>= getPropertyUString p
+
+-- |Set a property by name.  The name is interned.
+setProperty :: Anyable a => PropertyAccess -> Text -> a -> IO ()
+setProperty p name v = do
+  pName <- internUString name
+  setPropertyUString p pName v
+
+-- |Get a property given by an UString name, as generated accessors do with
+-- interned names.  The name must live as long as the property access.
+getPropertyUString :: Anyable a => PropertyAccess -> Ptr UString -> IO a
+getPropertyUString (PropertyAccess fp) pName =
+  withForeignPtr fp $ \ pAccess ->
+    allocaBytes B.anyStructSize $ \ pResult ->
+      allocaBytes B.anyStructSize $ \ pException -> do
+        ok <- cHsunoPropertiesGet pAccess pName pResult pException
+        when (ok == 0) $ propertyException pException
+        v <- anyFromUno pResult
+        B.anyDestruct pResult nullFunPtr
+        fromAnyIO v
+
+setPropertyUString :: Anyable a => PropertyAccess -> Ptr UString -> a -> IO ()
+setPropertyUString (PropertyAccess fp) pName v = do
+  a <- toAnyIO v
+  withForeignPtr fp $ \ pAccess ->
+    withAny a $ \ pValue ->
+      allocaBytes B.anyStructSize $ \ pException -> do
+        ok <- cHsunoPropertiesSet pAccess pName pValue pException
+        when (ok == 0) $ propertyException pException
+
+-- *Several Properties at Once
+
+-- |Set several properties of an object with one setPropertyValues call, or
+-- one call per property if the object does not implement XMultiPropertySet.
+-- A later value of the same property replaces an earlier one.
+setPropertiesAtOnce :: Reference a -> [(Text, Any)] -> IO ()
+setPropertiesAtOnce r props = do
+  -- the names must be sorted and unique
+  let sorted = Map.toAscList (Map.fromList props)
+      n = length sorted
+  withReference r $ \ pIface ->
+    withMany withUStringArg (map fst sorted) $ \ pNames ->
+      allocaProperties n $ \ ppNames pValues -> do
+        pokeArray ppNames pNames
+        allocaBytes B.anyStructSize $ \ pException -> do
+          status <- withAnyArray (map snd sorted) pValues $
+            cHsunoPropertiesSetValues (castPtr pIface) (fromIntegral n)
+              ppNames pValues pException
+          checkPropertiesStatus status pException
+
+-- |Get several properties of an object with one getPropertyValues call, or
+-- one call per property if the object does not implement XMultiPropertySet.
+getPropertiesAtOnce :: Reference a -> [Text] -> IO [Any]
+getPropertiesAtOnce r names = do
+  let sorted = Set.toAscList (Set.fromList names)
+      n = length sorted
+  values <- withReference r $ \ pIface ->
+    withMany withUStringArg sorted $ \ pNames ->
+      allocaProperties n $ \ ppNames pValues -> do
+        pokeArray ppNames pNames
+        allocaBytes B.anyStructSize $ \ pException -> do
+          status <- cHsunoPropertiesGetValues (castPtr pIface)
+                      (fromIntegral n) ppNames pValues pException
+          checkPropertiesStatus status pException
+          forM [0 .. n - 1] $ \ i -> do
+            let pValue = propertyValue pValues i
+            v <- anyFromUno pValue
+            B.anyDestruct pValue nullFunPtr
+            return v
+  let byName = Map.fromList (zip sorted values)
+  return (map (byName Map.!) names)
+
+-- |Allocate the names and values of n properties in one block.
+allocaProperties :: Int -> (Ptr (Ptr UString) -> Ptr B.Any -> IO b) -> IO b
+allocaProperties n f =
+  allocaBytes (n * (sizeOf nullPtr + B.anyStructSize)) $ \ p ->
+    f (castPtr p) (p `plusPtr` (n * sizeOf nullPtr))
+
+propertyValue :: Ptr B.Any -> Int -> Ptr B.Any
+propertyValue pValues i = pValues `plusPtr` (i * B.anyStructSize)
+
+-- *Batches
+
+-- |Property writes to an object, buffered until the batch is flushed.
+data PropertyBatch a = PropertyBatch (Reference a) (IORef (Map Text Any))
+
+-- |Run an action with a batch of property writes to an object, which are
+-- made together when the action ends.  If the action throws, the writes that
+-- have not been flushed are dropped.
+withPropertyBatch :: Reference a -> (PropertyBatch a -> IO b) -> IO b
+withPropertyBatch r f = do
+  batch <- PropertyBatch r <$> newIORef Map.empty
+  result <- f batch
+  flushPropertyBatch batch
+  return result
+
+-- |Buffer a property write; a later write to the same property replaces it.
+batchSetProperty :: Anyable v => PropertyBatch a -> Text -> v -> IO ()
+batchSetProperty (PropertyBatch _ writes) name v = do
+  a <- toAnyIO v
+  modifyIORef writes (Map.insert name a)
+
+-- |Get several properties, after making the buffered writes.
+batchGetProperties :: PropertyBatch a -> [Text] -> IO [Any]
+batchGetProperties batch@(PropertyBatch r _) names = do
+  flushPropertyBatch batch
+  getPropertiesAtOnce r names
+
+-- |Make the buffered writes now.
+flushPropertyBatch :: PropertyBatch a -> IO ()
+flushPropertyBatch (PropertyBatch r writes) = do
+  ws <- atomicModifyIORef writes (\ m -> (Map.empty, m))
+  unless (Map.null ws) $ setPropertiesAtOnce r (Map.toAscList ws)
+
+propertyException :: Ptr B.Any -> IO ()
+propertyException = throwUnoException
+
+-- |Check the status of a call made for several properties
+-- (HsunoPropertiesStatus).
+checkPropertiesStatus :: Int32 -> Ptr B.Any -> IO ()
+checkPropertiesStatus status pException = case status of
+  0 -> return ()
+  1 -> propertyException pException
+  2 -> error "object does not implement com.sun.star.beans.XPropertySet"
+  _ -> error "[properties] unexpected status"
+
+-- *Foreign imports
+
+foreign import ccall "hsuno_properties_new" cHsunoPropertiesNew
+  :: Ptr () -> IO (Ptr CPropertyAccess)
+
+foreign import ccall "&hsuno_properties_delete" cHsunoPropertiesDeletePtr
+  :: FunPtr (Ptr CPropertyAccess -> IO ())
+
+foreign import ccall "hsuno_properties_get" cHsunoPropertiesGet
+  :: Ptr CPropertyAccess -> Ptr UString -> Ptr B.Any -> Ptr B.Any -> IO Word8
+
+foreign import ccall "hsuno_properties_set" cHsunoPropertiesSet
+  :: Ptr CPropertyAccess -> Ptr UString -> Ptr B.Any -> Ptr B.Any -> IO Word8
+
+foreign import ccall "hsuno_properties_setValues" cHsunoPropertiesSetValues
+  :: Ptr () -> Int32 -> Ptr (Ptr UString) -> Ptr B.Any -> Ptr B.Any
+  -> IO Int32
+
+foreign import ccall "hsuno_properties_getValues" cHsunoPropertiesGetValues
+  :: Ptr () -> Int32 -> Ptr (Ptr UString) -> Ptr B.Any -> Ptr B.Any
+  -> IO Int32
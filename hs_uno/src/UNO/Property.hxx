@@ -0,0 +1,77 @@
+#ifndef HSUNO_UNO_PROPERTY_H
+#define HSUNO_UNO_PROPERTY_H
+
+#include "rtl/ustring.h"
+#include "uno/any2.h"
+
+/** Properties
+ *
+ * Property access to an object through com.sun.star.beans.XFastPropertySet.
+ * The handles of the properties are read from the object's XPropertySetInfo
+ * and kept by info, so that objects sharing an info read them once.  Objects
+ * without XFastPropertySet, and properties without a handle, are accessed by
+ * name through XPropertySet.
+ *
+ * The names passed to hsuno_properties_get and hsuno_properties_set must
+ * live as long as the property access (as interned names do): each access
+ * remembers the handles it looked up by name pointer.
+ */
+
+class HsunoPropertyAccess;
+
+/** Create the property access to an object, or return 0 if the object does
+ * not implement XPropertySet.
+ */
+extern "C"
+HsunoPropertyAccess * hsuno_properties_new (uno_Interface * pIface);
+
+extern "C"
+void hsuno_properties_delete (HsunoPropertyAccess * pAccess);
+
+/** Get the value of a property into the uninitialized Any pResult.
+ *
+ * Returns false if an exception was thrown; pException then holds it and
+ * pResult is left uninitialized.
+ */
+extern "C"
+sal_Bool hsuno_properties_get (HsunoPropertyAccess * pAccess,
+    rtl_uString * pName, uno_Any * pResult, uno_Any * pException);
+
+/** Set the value of a property.
+ *
+ * Returns false if an exception was thrown; pException then holds it.
+ */
+extern "C"
+sal_Bool hsuno_properties_set (HsunoPropertyAccess * pAccess,
+    rtl_uString * pName, uno_Any * pValue, uno_Any * pException);
+
+enum HsunoPropertiesStatus {
+    HSUNO_PROPERTIES_OK,
+    // a call threw; pException holds the exception
+    HSUNO_PROPERTIES_EXCEPTION,
+    // the object implements neither XMultiPropertySet nor XPropertySet
+    HSUNO_PROPERTIES_NOT_SUPPORTED
+};
+
+/** Set several properties of an object.
+ *
+ * The names must be sorted and unique.  With XMultiPropertySet this is one
+ * setPropertyValues call, otherwise one XPropertySet call per property up to
+ * the first that fails.  Returns an HsunoPropertiesStatus.
+ */
+extern "C"
+sal_Int32 hsuno_properties_setValues (uno_Interface * pIface,
+    sal_Int32 nProperties, rtl_uString ** ppNames, uno_Any * pValues,
+    uno_Any * pException);
+
+/** Get several properties of an object into the uninitialized Anys pValues.
+ *
+ * The names must be sorted and unique.  Returns an HsunoPropertiesStatus;
+ * unless it is HSUNO_PROPERTIES_OK, pValues are left uninitialized.
+ */
+extern "C"
+sal_Int32 hsuno_properties_getValues (uno_Interface * pIface,
+    sal_Int32 nProperties, rtl_uString ** ppNames, uno_Any * pValues,
+    uno_Any * pException);
+
+#endif // HSUNO_UNO_PROPERTY_H
@@ -1,21 +1,117 @@
+{-# LANGUAGE ScopedTypeVariables #-}
 module UNO.Reference where
 
 import Control.Applicative ((<$>))
+import Control.Monad (forM, when)
+import Data.IORef
+import Data.Map (Map)
+import qualified Data.Map as Map
+import Data.Text (Text)
 import Foreign
 
+import UNO.Scope
 import UNO.Types
-import qualified UNO.Binary as UNO (queryInterface, cInterfaceReleasePtr)
+import qualified UNO.Binary as UNO (queryInterfacePtr, cHsunoQueryInterfaces)
 
-data Reference a = Ref { unRef :: ForeignPtr a }
+data Reference a = Ref
+  { unRef    :: ForeignPtr a
+  , refScope :: Maybe UnoScope -- ^ the scope releasing the interface, if any
+  , refCache :: Maybe InterfaceCache
+  }
+
+-- |Interfaces already obtained from an object, keyed by type name.
+--
+-- The cache is shared by every reference derived from the same object
+-- through 'queryInterface'.  It only keeps interfaces released the same way
+-- as the object it was made for (by finalizers, or by the same scope), so
+-- that none outlives the references that can reach it.
+data InterfaceCache = InterfaceCache
+  { cacheScope   :: Maybe UnoScope
+  , cacheEntries :: IORef (Map Text (ForeignPtr ()))
+  }
 
 -- |Make a reference to a UNO interface.
+--
+-- Inside 'withUnoScope', the reference is released when the scope is left;
+-- otherwise it is released by a finalizer.
 mkReference :: IsUnoType a => Ptr a -> IO (Reference a)
-mkReference ptr = Ref <$> newForeignPtr UNO.cInterfaceReleasePtr ptr
+mkReference ptr = do
+  (fp, scope) <- adoptInterface ptr
+  return (Ref fp scope Nothing)
+
+-- |Make a reference to a UNO interface that caches the results of
+-- 'queryInterface'.
+mkCachedReference :: IsUnoType a => Ptr a -> IO (Reference a)
+mkCachedReference ptr = mkReference ptr >>= withInterfaceCache
+
+-- |Attach an interface cache to a reference, if it does not have one yet.
+--
+-- Casts of the returned reference, and of the references obtained from it,
+-- only query the object the first time each interface is requested.
+withInterfaceCache :: forall a . IsUnoType a => Reference a -> IO (Reference a)
+withInterfaceCache r@(Ref _ _ (Just _)) = return r
+withInterfaceCache (Ref fp scope Nothing) = do
+  entries <- newIORef (Map.singleton (getUnoTypeName (undefined :: a))
+                                     (castForeignPtr fp))
+  return (Ref fp scope (Just (InterfaceCache scope entries)))
 
 -- |Use the pointer of the UNO interface referenced.
 withReference :: Reference a -> (Ptr a -> IO b) -> IO b
 withReference rA = withForeignPtr (unRef rA)
 
 -- |Make a reference to a new interface after querying the referenced interface.
-queryInterface :: IsUnoType b => Reference a -> IO (Reference b)
-queryInterface rA = Ref <$> UNO.queryInterface (unRef rA)
+queryInterface :: forall a b . IsUnoType b => Reference a -> IO (Reference b)
+queryInterface (Ref fpA _ Nothing) = do
+  (fpB, scope) <- adoptInterface =<< UNO.queryInterfacePtr fpA
+  return (Ref fpB scope Nothing)
+queryInterface (Ref fpA _ (Just cache)) = do
+  let tn = getUnoTypeName (undefined :: b)
+  cached <- Map.lookup tn <$> readIORef (cacheEntries cache)
+  case cached of
+    Just fp -> return (Ref (castForeignPtr fp) (cacheScope cache) (Just cache))
+    Nothing -> do
+      pB <- UNO.queryInterfacePtr fpA
+      (fpB, scope) <- adoptInterface pB
+      when (pB /= nullPtr) $ cacheInterface cache tn scope (castForeignPtr fpB)
+      return (Ref fpB scope (Just cache))
+
+-- |Query several interfaces, given by type name, with one call into the
+-- runtime (which still queries the object once per interface).
+--
+-- The interfaces found are added to the reference's cache, if it has one.
+queryInterfacesByName :: Reference a -> [Text] -> IO [Maybe (Reference ())]
+queryInterfacesByName rA tns = do
+  fpTypes <- mapM getTypeDescription tns
+  let n = length tns
+  ptrs <- withMany withForeignPtr fpTypes $ \ pTypes ->
+    withArray pTypes $ \ pTypesArr ->
+      allocaArray n $ \ pResults ->
+        withReference rA $ \ pA -> do
+          UNO.cHsunoQueryInterfaces pA (fromIntegral n) pTypesArr pResults
+          peekArray n pResults
+  forM (zip tns ptrs) $ \ (tn, p) ->
+    if p == nullPtr
+      then return Nothing
+      else do
+        (fp, scope) <- adoptInterface p
+        maybe (return ()) (\ cache -> cacheInterface cache tn scope fp)
+          (refCache rA)
+        return (Just (Ref fp scope (refCache rA)))
+
+-- |Fill the reference's cache with the given interfaces, so later casts to
+-- them cost nothing.  Does nothing for a reference without a cache.
+prefetchInterfaces :: Reference a -> [Text] -> IO ()
+prefetchInterfaces (Ref _ _ Nothing) _ = return ()
+prefetchInterfaces rA@(Ref _ _ (Just cache)) tns = do
+  cached <- readIORef (cacheEntries cache)
+  let missing = filter (`Map.notMember` cached) tns
+  when (not (null missing)) $ queryInterfacesByName rA missing >> return ()
+
+-- |Cache an interface adopted with the given scope, if it is released the
+-- same way as the cache's object.
+cacheInterface :: InterfaceCache -> Text -> Maybe UnoScope -> ForeignPtr ()
+               -> IO ()
+cacheInterface cache tn scope fp =
+  when (scope == cacheScope cache) $
+    atomicModifyIORef' (cacheEntries cache) $ \ m ->
+      (Map.insertWith (\ _ old -> old) tn fp m, ())
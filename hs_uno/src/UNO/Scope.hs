@@ -0,0 +1,72 @@
+module UNO.Scope
+  ( UnoScope
+  , withUnoScope
+  , currentScope
+  , adoptInterface
+  ) where
+
+import Control.Applicative ((<$>))
+import Control.Concurrent (ThreadId, myThreadId)
+import Control.Exception (finally)
+import Data.IORef
+import Data.Map (Map)
+import qualified Data.Map as Map
+import Foreign
+import System.IO.Unsafe (unsafePerformIO)
+
+import qualified UNO.Binary as UNO (cInterfaceReleasePtr, cInterfaceReleaseAll)
+
+-- |A region in which references are released together, when it is left,
+-- instead of by finalizers.
+--
+-- References made in a scope must not be used after the scope is left.
+newtype UnoScope = UnoScope (IORef [Ptr ()]) deriving Eq
+
+{-# NOINLINE activeScopes #-}
+activeScopes :: IORef (Map ThreadId UnoScope)
+activeScopes = unsafePerformIO (newIORef Map.empty)
+
+-- |Run an action in a new scope.  The references made by the current thread
+-- inside it (through 'UNO.Reference.mkReference' and
+-- 'UNO.Reference.queryInterface') have no finalizers and are all released
+-- in one pass when the action finishes.
+withUnoScope :: (UnoScope -> IO a) -> IO a
+withUnoScope f = do
+  tid <- myThreadId
+  scope <- UnoScope <$> newIORef []
+  outer <- atomicModifyIORef' activeScopes $ \ m ->
+    (Map.insert tid scope m, Map.lookup tid m)
+  f scope `finally` do
+    atomicModifyIORef' activeScopes $ \ m ->
+      (maybe (Map.delete tid m) (\ o -> Map.insert tid o m) outer, ())
+    releaseScope scope
+
+-- |The innermost scope of the current thread, if any.
+currentScope :: IO (Maybe UnoScope)
+currentScope = do
+  scopes <- readIORef activeScopes
+  if Map.null scopes
+    then return Nothing
+    else (`Map.lookup` scopes) <$> myThreadId
+
+-- |Take ownership of an acquired interface pointer.
+--
+-- Inside a scope, the pointer is released when the scope is left, which is
+-- returned; otherwise it is released by a finalizer.
+adoptInterface :: Ptr a -> IO (ForeignPtr a, Maybe UnoScope)
+adoptInterface ptr = do
+  scope <- currentScope
+  case scope of
+    Nothing -> do
+      fp <- newForeignPtr UNO.cInterfaceReleasePtr ptr
+      return (fp, Nothing)
+    Just s@(UnoScope refs) -> do
+      atomicModifyIORef' refs $ \ ps -> (castPtr ptr : ps, ())
+      fp <- newForeignPtr_ ptr
+      return (fp, Just s)
+
+releaseScope :: UnoScope -> IO ()
+releaseScope (UnoScope refs) = do
+  ptrs <- atomicModifyIORef' refs $ \ ps -> ([], ps)
+  withArrayLen (filter (/= nullPtr) ptrs) $ \ n pPtrs ->
+    UNO.cInterfaceReleaseAll pPtrs (fromIntegral n)
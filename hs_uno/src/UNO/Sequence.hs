@@ -0,0 +1,154 @@
+{-# LANGUAGE ScopedTypeVariables #-}
+{-# LANGUAGE MultiParamTypeClasses, FunctionalDependencies #-}
+{-# LANGUAGE FlexibleInstances #-}
+module UNO.Sequence
+  ( SequenceView
+  , seqViewLength
+  , adoptSequence
+  , viewSequence
+  , withSequenceView
+  , sequenceViewToVector
+  , textsFromSequence
+  , referencesFromSequence
+  , ToSequence (..)
+  , sequenceFromVector
+  , sequenceFromByteString
+  , vectorToSequence
+  , byteStringToSequence
+  , textsToSequence
+  , referencesToSequence
+  ) where
+
+import Control.Applicative ((<$>))
+import Control.Exception (finally)
+import Control.Monad (forM, forM_)
+import Data.ByteString (ByteString)
+import Data.ByteString.Unsafe (unsafeUseAsCStringLen)
+import Data.Text (Text)
+import qualified Data.Vector.Storable as V
+import Foreign
+import qualified Foreign.Concurrent as FC
+import Foreign.ForeignPtr.Unsafe (unsafeForeignPtrToPtr)
+
+import qualified UNO.Binary as B
+import UNO.Reference
+import UNO.Text
+import UNO.Types
+
+-- |A view of the elements of a uno_Sequence, without copying them.
+--
+-- The elements stay valid as long as the view (or any vector made from it)
+-- is alive.
+data SequenceView a = SequenceView
+  { seqViewSequence :: ForeignPtr (CSequence a)
+  , seqViewElements :: ForeignPtr a
+  , seqViewLength   :: Int
+  }
+
+-- |Take ownership of a sequence reference, such as the result of a call.
+adoptSequence :: forall a . IsUnoType a => Ptr (CSequence a) -> IO (SequenceView a)
+adoptSequence pSequence = do
+  -- see B.newSequence on keeping the bare type description pointer
+  fpType <- getUnoType (undefined :: CSequence a)
+  fpSequence <- newForeignPtrEnv B.cUnoSequenceReleaseFinalizer
+    (unsafeForeignPtrToPtr fpType) pSequence
+  viewSequence fpSequence
+
+-- |View the elements of a sequence kept alive by the given pointer (e.g. the
+-- sequence of an 'ASequence').
+viewSequence :: ForeignPtr (CSequence a) -> IO (SequenceView a)
+viewSequence fpSequence = withForeignPtr fpSequence $ \ pSequence -> do
+  len <- fromIntegral <$> B.cUnoSequenceGetLength pSequence
+  pElements <- B.cUnoSequenceGetArray pSequence
+  fpElements <- FC.newForeignPtr pElements (touchForeignPtr fpSequence)
+  return (SequenceView fpSequence fpElements len)
+
+withSequenceView :: SequenceView a -> (Ptr (CSequence a) -> IO b) -> IO b
+withSequenceView = withForeignPtr . seqViewSequence
+
+-- |The elements of a sequence as a storable vector sharing their memory.
+sequenceViewToVector :: Storable a => SequenceView a -> V.Vector a
+sequenceViewToVector v = V.unsafeFromForeignPtr0 (seqViewElements v) (seqViewLength v)
+
+-- |Convert the strings of a sequence in one pass over its elements.
+textsFromSequence :: Ptr (CSequence UString) -> IO [Text]
+textsFromSequence pSequence = do
+  len <- fromIntegral <$> B.cUnoSequenceGetLength pSequence
+  pElements <- B.cUnoSequenceGetArray pSequence
+  mapM uStringToText =<< peekArray len pElements
+
+-- |Make references to the interfaces of a sequence in one pass over its
+-- elements.  Null elements are kept as null references.
+referencesFromSequence :: forall a b . IsUnoType b
+                       => Ptr (CSequence a) -> IO [Reference b]
+referencesFromSequence pSequence = do
+  len <- fromIntegral <$> B.cUnoSequenceGetLength pSequence
+  pElements <- castPtr <$> B.cUnoSequenceGetArray pSequence
+  ptrs <- peekArray len pElements
+  -- a type description starts like a reference to it
+  fpType <- getUnoType (undefined :: b)
+  withForeignPtr fpType $ \ pType -> do
+    pTypeName <- typeRefGetName (castPtr pType)
+    forM ptrs $ \ p -> do
+      if p == nullPtr then return () else B.cInterfaceAcquireTyped p pTypeName
+      mkReference p
+
+-- *Building sequences
+
+-- |Values that can be passed as UNO sequences with elements of type a.
+class IsUnoType a => ToSequence s a | s -> a where
+  -- |Run an action with a sequence holding the value.  A sequence built for
+  -- the action is released right after it.
+  withSequence :: s -> (Ptr (CSequence a) -> IO b) -> IO b
+
+instance IsUnoType a => ToSequence (SequenceView a) a where
+  withSequence = withSequenceView
+
+instance (IsUnoType a, Storable a) => ToSequence (V.Vector a) a where
+  withSequence = withNewSequence . vectorToSequence
+
+instance ToSequence ByteString Word8 where
+  withSequence = withNewSequence . byteStringToSequence
+
+instance ToSequence [Text] UString where
+  withSequence = withNewSequence . textsToSequence
+
+instance IsUnoType a => ToSequence [Reference a] a where
+  withSequence = withNewSequence . referencesToSequence
+
+withNewSequence :: IO (ForeignPtr (CSequence a)) -> (Ptr (CSequence a) -> IO b)
+                -> IO b
+withNewSequence new f = do
+  fpSequence <- new
+  withForeignPtr fpSequence f `finally` finalizeForeignPtr fpSequence
+
+sequenceFromVector :: (IsUnoType a, Storable a) => V.Vector a -> IO (SequenceView a)
+sequenceFromVector v = viewSequence =<< vectorToSequence v
+
+sequenceFromByteString :: ByteString -> IO (SequenceView Word8)
+sequenceFromByteString bs = viewSequence =<< byteStringToSequence bs
+
+-- |Copy the elements of a vector into a new sequence, in one allocation.
+vectorToSequence :: (IsUnoType a, Storable a) => V.Vector a
+                 -> IO (ForeignPtr (CSequence a))
+vectorToSequence v = V.unsafeWith v $ \ p -> B.newSequence p (V.length v)
+
+-- |Copy the bytes of a string into a new []byte sequence.
+byteStringToSequence :: ByteString -> IO (ForeignPtr (CSequence Word8))
+byteStringToSequence bs = unsafeUseAsCStringLen bs $ \ (p, len) ->
+  B.newSequence (castPtr p) len
+
+-- |Make a []string sequence, creating each string in place.
+textsToSequence :: [Text] -> IO (ForeignPtr (CSequence UString))
+textsToSequence ts = do
+  fpSequence <- B.newSequence nullPtr (length ts)
+  withForeignPtr fpSequence $ \ pSequence ->
+    forM_ (zip [0 ..] ts) $ \ (i, t) ->
+      B.cHsunoSequenceAdoptString pSequence i =<< uStringNew t
+  return fpSequence
+
+-- |Make a sequence of interfaces; they are all acquired by one call.
+referencesToSequence :: IsUnoType a => [Reference a]
+                     -> IO (ForeignPtr (CSequence a))
+referencesToSequence rs = withMany withReference rs $ \ ps ->
+  withArrayLen ps $ \ len pElements -> B.newSequence (castPtr pElements) len
@@ -17,6 +17,8 @@ unoGetSingletonFromContext :: IsUnoType b => Text -> Reference a -> IO (Referenc
 unoGetSingletonFromContext t rContext =
   withUString ("/singletons/" `append` t) $ \ sSingletonSpecifier ->
     withReference rContext $ \ pContext -> do
-      withAny AVoid $ \ pAny -> do
+      allocaBytes anyStructSize $ \ pAny -> do
         hsunoGetSingletonFromContext sSingletonSpecifier (castPtr pContext) pAny
-        fromAnyIO =<< anyFromUno pAny
+        r <- fromAnyIO =<< anyFromUno pAny
+        anyDestruct pAny nullFunPtr
+        return r
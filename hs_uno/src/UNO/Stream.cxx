@@ -0,0 +1,315 @@
+#include "Stream.hxx"
+#include "Accounting.hxx"
+
+#include "com/sun/star/io/XInputStream.hpp"
+#include "com/sun/star/io/XOutputStream.hpp"
+#include "com/sun/star/io/XSeekable.hpp"
+#include "com/sun/star/lang/IllegalArgumentException.hpp"
+#include "cppuhelper/implbase.hxx"
+#include "osl/mutex.hxx"
+#include "rtl/ref.hxx"
+#include "uno/mapping.hxx"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace io = com::sun::star::io;
+namespace uno = com::sun::star::uno;
+
+namespace {
+
+// Map the interface of the given type of a C++ object to binary UNO.
+uno_Interface * mapToUno (uno::Reference< uno::XInterface > const & xObject,
+    typelib_TypeDescriptionReference * pType)
+{
+  uno::Type type (pType);
+  uno::Any aInterface (xObject->queryInterface(type));
+  if (!aInterface.hasValue())
+    return 0;
+  uno::Mapping cpp2uno (uno::Environment::getCurrent(),
+      uno::Environment(UNO_LB_UNO));
+  uno_Interface * pUno = static_cast< uno_Interface * >(cpp2uno.mapInterface(
+      *static_cast< uno::XInterface * const * >(aInterface.getValue()), type));
+  if (pUno != 0)
+    hsunoAccountingInterfaceAcquired(pUno, pType->pTypeName);
+  return pUno;
+}
+
+// Input stream
+//
+// The stable pointers of destroyed streams are not freed here, as the last
+// reference may be dropped by any thread, possibly after the Haskell runtime
+// has exited; they are queued and freed by Haskell.
+
+std::mutex releasedOwnersMutex;
+std::vector< void * > releasedOwners;
+
+class InputStream
+  : public cppu::WeakImplHelper< io::XInputStream, io::XSeekable >
+{
+public:
+  InputStream (sal_Int8 const * pData, sal_Int64 nSize, void * pOwner)
+    : pData(pData), nSize(nSize), nPosition(0), pOwner(pOwner), bClosed(false)
+  {}
+
+  // XInputStream
+
+  sal_Int32 SAL_CALL readBytes (uno::Sequence< sal_Int8 > & aData,
+      sal_Int32 nBytesToRead) override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    if (nBytesToRead < 0)
+      throw io::BufferSizeExceededException();
+    sal_Int32 n = static_cast< sal_Int32 >(
+        std::min< sal_Int64 >(nBytesToRead, nSize - nPosition));
+    aData.realloc(n);
+    std::memcpy(aData.getArray(), pData + nPosition, n);
+    nPosition += n;
+    return n;
+  }
+
+  sal_Int32 SAL_CALL readSomeBytes (uno::Sequence< sal_Int8 > & aData,
+      sal_Int32 nMaxBytesToRead) override
+  {
+    return readBytes(aData, nMaxBytesToRead);
+  }
+
+  void SAL_CALL skipBytes (sal_Int32 nBytesToSkip) override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    if (nBytesToSkip < 0)
+      throw io::BufferSizeExceededException();
+    nPosition += std::min< sal_Int64 >(nBytesToSkip, nSize - nPosition);
+  }
+
+  sal_Int32 SAL_CALL available () override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    return static_cast< sal_Int32 >(
+        std::min< sal_Int64 >(SAL_MAX_INT32, nSize - nPosition));
+  }
+
+  void SAL_CALL closeInput () override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    bClosed = true;
+  }
+
+  // XSeekable
+
+  void SAL_CALL seek (sal_Int64 nLocation) override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    if (nLocation < 0 || nLocation > nSize)
+      throw com::sun::star::lang::IllegalArgumentException();
+    nPosition = nLocation;
+  }
+
+  sal_Int64 SAL_CALL getPosition () override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    return nPosition;
+  }
+
+  sal_Int64 SAL_CALL getLength () override
+  {
+    osl::MutexGuard guard (mutex);
+    checkOpen();
+    return nSize;
+  }
+
+private:
+  ~InputStream ()
+  {
+    std::lock_guard< std::mutex > lock (releasedOwnersMutex);
+    releasedOwners.push_back(pOwner);
+  }
+
+  void checkOpen ()
+  {
+    if (bClosed)
+      throw io::NotConnectedException();
+  }
+
+  osl::Mutex mutex;
+  sal_Int8 const * pData;
+  sal_Int64 nSize;
+  sal_Int64 nPosition;
+  void * pOwner;
+  bool bClosed;
+};
+
+}
+
+extern "C"
+uno_Interface * hsuno_inputstream_new (sal_Int8 const * pData, sal_Int64 nSize,
+    void * pOwner, typelib_TypeDescriptionReference * pType)
+{
+  uno::Reference< io::XInputStream > xStream (
+      new InputStream(pData, nSize, pOwner));
+  return mapToUno(xStream, pType);
+}
+
+extern "C"
+void * hsuno_inputstream_takeReleasedOwner ()
+{
+  std::lock_guard< std::mutex > lock (releasedOwnersMutex);
+  if (releasedOwners.empty())
+    return 0;
+  void * pOwner = releasedOwners.back();
+  releasedOwners.pop_back();
+  return pOwner;
+}
+
+// Output stream
+//
+// Written data is kept in chunks as written (one per writeBytes), read by
+// Haskell from the front.
+
+class HsunoOutputStream : public cppu::WeakImplHelper< io::XOutputStream >
+{
+public:
+  explicit HsunoOutputStream (sal_Int32 nCapacity)
+    : nCapacity(nCapacity), nBuffered(0), nFrontRead(0), bClosed(false),
+      bReaderGone(false)
+  {}
+
+  // XOutputStream
+
+  void SAL_CALL writeBytes (uno::Sequence< sal_Int8 > const & aData) override
+  {
+    std::unique_lock< std::mutex > lock (mutex);
+    // wait for room, but never refuse a chunk to an empty buffer
+    while (nCapacity > 0 && nBuffered > 0
+           && nBuffered + aData.getLength() > nCapacity
+           && !bReaderGone && !bClosed)
+      readable.wait(lock);
+    if (bClosed || bReaderGone)
+      throw io::NotConnectedException();
+    if (aData.getLength() == 0)
+      return;
+    chunks.push_back(std::vector< sal_Int8 >(
+        aData.getConstArray(), aData.getConstArray() + aData.getLength()));
+    nBuffered += aData.getLength();
+    written.notify_all();
+  }
+
+  void SAL_CALL flush () override
+  {
+    std::lock_guard< std::mutex > lock (mutex);
+    if (bClosed || bReaderGone)
+      throw io::NotConnectedException();
+  }
+
+  void SAL_CALL closeOutput () override
+  {
+    std::lock_guard< std::mutex > lock (mutex);
+    if (bClosed || bReaderGone)
+      throw io::NotConnectedException();
+    bClosed = true;
+    written.notify_all();
+  }
+
+  // Haskell side
+
+  void finish ()
+  {
+    std::lock_guard< std::mutex > lock (mutex);
+    bClosed = true;
+    written.notify_all();
+    readable.notify_all();
+  }
+
+  sal_Int32 read (sal_Int8 * pBuffer, sal_Int32 nMax)
+  {
+    if (nMax <= 0)
+      return 0;
+    std::unique_lock< std::mutex > lock (mutex);
+    while (chunks.empty() && !bClosed)
+      written.wait(lock);
+    sal_Int32 n = 0;
+    while (n < nMax && !chunks.empty()) {
+      std::vector< sal_Int8 > const & front (chunks.front());
+      sal_Int32 nCopy = std::min< sal_Int32 >(nMax - n,
+          static_cast< sal_Int32 >(front.size()) - nFrontRead);
+      std::memcpy(pBuffer + n, front.data() + nFrontRead, nCopy);
+      n += nCopy;
+      nFrontRead += nCopy;
+      if (nFrontRead == static_cast< sal_Int32 >(front.size())) {
+        chunks.pop_front();
+        nFrontRead = 0;
+      }
+    }
+    nBuffered -= n;
+    readable.notify_all();
+    return n;
+  }
+
+  void releaseReader ()
+  {
+    {
+      std::lock_guard< std::mutex > lock (mutex);
+      bReaderGone = true;
+      chunks.clear();
+      nBuffered = 0;
+      readable.notify_all();
+    }
+    release();
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable written;
+  std::condition_variable readable;
+  std::deque< std::vector< sal_Int8 > > chunks;
+  sal_Int32 nCapacity;
+  sal_Int64 nBuffered;
+  sal_Int32 nFrontRead;
+  bool bClosed;
+  bool bReaderGone;
+};
+
+extern "C"
+HsunoOutputStream * hsuno_outputstream_new (sal_Int32 nCapacity)
+{
+  HsunoOutputStream * pStream = new HsunoOutputStream(nCapacity);
+  // the reference held by Haskell, dropped by hsuno_outputstream_release
+  pStream->acquire();
+  return pStream;
+}
+
+extern "C"
+uno_Interface * hsuno_outputstream_getInterface (HsunoOutputStream * pStream,
+    typelib_TypeDescriptionReference * pType)
+{
+  return mapToUno(static_cast< cppu::OWeakObject * >(pStream), pType);
+}
+
+extern "C"
+sal_Int32 hsuno_outputstream_read (HsunoOutputStream * pStream,
+    sal_Int8 * pBuffer, sal_Int32 nMax)
+{
+  return pStream->read(pBuffer, nMax);
+}
+
+extern "C"
+void hsuno_outputstream_finish (HsunoOutputStream * pStream)
+{
+  pStream->finish();
+}
+
+extern "C"
+void hsuno_outputstream_release (HsunoOutputStream * pStream)
+{
+  pStream->releaseReader();
+}
@@ -0,0 +1,126 @@
+{-# LANGUAGE ScopedTypeVariables #-}
+module UNO.Stream
+  ( newInputStream
+  , OutputStream
+  , newOutputStream
+  , outputStreamReference
+  , finishOutputStream
+  , readOutputStream
+  , readOutputStreamToEnd
+  ) where
+
+import Control.Applicative ((<$>))
+import Control.Monad (unless)
+import Data.ByteString (ByteString)
+import qualified Data.ByteString as BS
+import Data.ByteString.Internal (createAndTrim)
+import Data.ByteString.Unsafe (unsafeUseAsCStringLen)
+import Foreign
+
+import qualified UNO.Binary as B
+import UNO.Reference
+import UNO.Types
+
+-- *Input Streams
+
+-- |Make a stream reading the bytes of a string, which implements
+-- com.sun.star.io.XInputStream and com.sun.star.io.XSeekable.
+--
+-- The reference is to the interface 'a' of the stream (null if it is none
+-- of the above).
+newInputStream :: forall a . IsUnoType a => ByteString -> IO (Reference a)
+newInputStream bs = do
+  freeReleasedOwners
+  -- strict strings are pinned, so the stream may keep reading the bytes
+  -- until it frees this pointer
+  owner <- newStablePtr bs
+  fpType <- getUnoType (undefined :: a)
+  pStream <- unsafeUseAsCStringLen bs $ \ (pData, len) ->
+    withForeignPtr fpType $ \ pType ->
+      cHsunoInputStreamNew (castPtr pData) (fromIntegral len)
+        (castStablePtrToPtr owner) (castPtr pType)
+  mkReference (castPtr pStream)
+
+-- |Free the stable pointers of the input streams destroyed so far, which the
+-- streams cannot do themselves from whatever thread drops them.
+freeReleasedOwners :: IO ()
+freeReleasedOwners = do
+  owner <- cHsunoInputStreamTakeReleasedOwner
+  unless (owner == nullPtr) $ do
+    freeStablePtr (castPtrToStablePtr owner)
+    freeReleasedOwners
+
+-- *Output Streams
+
+data COutputStream
+
+-- |A stream implementing com.sun.star.io.XOutputStream whose contents are
+-- read from Haskell.
+newtype OutputStream = OutputStream (ForeignPtr COutputStream)
+
+-- |Make an output stream buffering at most the given number of bytes (0 for
+-- no limit).
+--
+-- With a limit, writers block while the buffer is full, so the stream must
+-- be read from another thread than the one making the call that writes it.
+newOutputStream :: Int -> IO OutputStream
+newOutputStream capacity = OutputStream <$>
+  (newForeignPtr cHsunoOutputStreamReleasePtr
+    =<< cHsunoOutputStreamNew (fromIntegral capacity))
+
+-- |Reference the interface 'a' of an output stream (null if it has none).
+outputStreamReference :: forall a . IsUnoType a => OutputStream -> IO (Reference a)
+outputStreamReference (OutputStream fp) = do
+  fpType <- getUnoType (undefined :: a)
+  pInterface <- withForeignPtr fp $ \ pStream ->
+    withForeignPtr fpType $ \ pType ->
+      cHsunoOutputStreamGetInterface pStream (castPtr pType)
+  mkReference (castPtr pInterface)
+
+-- |Mark the end of what is written to the stream, for calls that write it
+-- without closing it (e.g. storeToURL): once the call has returned, this lets
+-- readers stop at the end of the data.  Further writes fail.
+finishOutputStream :: OutputStream -> IO ()
+finishOutputStream (OutputStream fp) = withForeignPtr fp cHsunoOutputStreamFinish
+
+-- |Read at most the given number of bytes written to the stream, waiting for
+-- some to be written.  The result is empty at once for a count of 0 or less,
+-- and once the stream has been closed or finished and everything has been
+-- read.
+readOutputStream :: OutputStream -> Int -> IO ByteString
+readOutputStream _ n | n <= 0 = return BS.empty
+readOutputStream (OutputStream fp) n = withForeignPtr fp $ \ pStream ->
+  createAndTrim n $ \ pBuffer ->
+    fromIntegral <$> cHsunoOutputStreamRead pStream (castPtr pBuffer)
+      (fromIntegral n)
+
+-- |Read everything written to the stream until it is closed or finished.
+readOutputStreamToEnd :: OutputStream -> IO ByteString
+readOutputStreamToEnd s = BS.concat <$> go
+  where go = do
+          chunk <- readOutputStream s 65536
+          if BS.null chunk then return [] else (chunk :) <$> go
+
+foreign import ccall "hsuno_inputstream_new" cHsunoInputStreamNew
+  :: Ptr Int8 -> Int64 -> Ptr () -> Ptr TypeDescriptionReference
+  -> IO (Ptr B.UnoInterface)
+
+foreign import ccall "hsuno_inputstream_takeReleasedOwner"
+  cHsunoInputStreamTakeReleasedOwner :: IO (Ptr ())
+
+foreign import ccall "hsuno_outputstream_new" cHsunoOutputStreamNew
+  :: Int32 -> IO (Ptr COutputStream)
+
+foreign import ccall "hsuno_outputstream_getInterface"
+  cHsunoOutputStreamGetInterface
+  :: Ptr COutputStream -> Ptr TypeDescriptionReference
+  -> IO (Ptr B.UnoInterface)
+
+foreign import ccall "hsuno_outputstream_read" cHsunoOutputStreamRead
+  :: Ptr COutputStream -> Ptr Int8 -> Int32 -> IO Int32
+
+foreign import ccall "hsuno_outputstream_finish" cHsunoOutputStreamFinish
+  :: Ptr COutputStream -> IO ()
+
+foreign import ccall "&hsuno_outputstream_release" cHsunoOutputStreamReleasePtr
+  :: FunPtr (Ptr COutputStream -> IO ())
@@ -0,0 +1,69 @@
+#ifndef HSUNO_UNO_STREAM_H
+#define HSUNO_UNO_STREAM_H
+
+#include "typelib/typedescription.h"
+#include "uno/any2.h"
+
+/** Streams
+ *
+ * Implementations of com.sun.star.io streams over memory owned by Haskell,
+ * so that documents can be passed in and out without temporary files.
+ */
+
+/** Create an input stream (XInputStream and XSeekable) reading nSize bytes
+ * at pData.
+ *
+ * The memory must not move; pOwner is a Haskell stable pointer that keeps it
+ * alive and is handed back by hsuno_inputstream_takeReleasedOwner once the
+ * stream is destroyed.  Returns the interface of type pType of the stream, or
+ * 0 if it does not implement it.
+ */
+extern "C"
+uno_Interface * hsuno_inputstream_new (sal_Int8 const * pData, sal_Int64 nSize,
+    void * pOwner, typelib_TypeDescriptionReference * pType);
+
+/** Take the owner of a destroyed input stream, to be freed by the caller, or
+ * 0 if there is none left.
+ */
+extern "C"
+void * hsuno_inputstream_takeReleasedOwner ();
+
+class HsunoOutputStream;
+
+/** Create an output stream (XOutputStream) buffering what is written to it
+ * until it is read from Haskell.
+ *
+ * With nCapacity greater than 0, writers block while more than nCapacity
+ * bytes are buffered, so the stream must then be read from another thread.
+ */
+extern "C"
+HsunoOutputStream * hsuno_outputstream_new (sal_Int32 nCapacity);
+
+/** Retrieve the interface of type pType of an output stream, or 0.
+ */
+extern "C"
+uno_Interface * hsuno_outputstream_getInterface (HsunoOutputStream * pStream,
+    typelib_TypeDescriptionReference * pType);
+
+/** Read at most nMax bytes written to an output stream, blocking until some
+ * are available.
+ *
+ * Returns 0 at once when nMax is not positive, and once the stream has been
+ * closed or finished and everything has been read.
+ */
+extern "C"
+sal_Int32 hsuno_outputstream_read (HsunoOutputStream * pStream,
+    sal_Int8 * pBuffer, sal_Int32 nMax);
+
+/** Mark the end of the data of an output stream from Haskell, for writers
+ * that do not close it.  Readers stop waiting and further writes fail.
+ */
+extern "C"
+void hsuno_outputstream_finish (HsunoOutputStream * pStream);
+
+/** Drop the Haskell side of an output stream.  Further writes fail.
+ */
+extern "C"
+void hsuno_outputstream_release (HsunoOutputStream * pStream);
+
+#endif // HSUNO_UNO_STREAM_H
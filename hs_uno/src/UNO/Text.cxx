@@ -1,7 +1,14 @@
 #include "Text.h"
+#include "Accounting.hxx"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HSUNO_TEXT_X86
+#include <immintrin.h>
+#endif
 
 extern "C"
 OUString * create_oustring (sal_Unicode * buf, sal_Int32 len) {
+	hsunoAccountingCount(HSUNO_COUNT_OUSTRING_CREATED);
 	return new OUString(buf, len);
 }
 
@@ -17,6 +24,7 @@ sal_Int32 oustring_length (OUString * str) {
 
 extern "C"
 void delete_oustring (OUString * str) {
+  hsunoAccountingCount(HSUNO_COUNT_OUSTRING_FREED);
   delete str;
 }
 
@@ -27,17 +35,281 @@ rtl_uString * oustringGetUString (OUString * str) {
 
 extern "C"
 OUString * oustringFromUString (rtl_uString * ustr) {
+  hsunoAccountingCount(HSUNO_COUNT_OUSTRING_CREATED);
   OUString * str = new OUString (ustr, SAL_NO_ACQUIRE);
   return str;
 }
 
+/* UTF-8 <-> UTF-16 transcoding
+ *
+ * Texts are UTF-8 since text-2.0, so they are transcoded when they are passed
+ * to or taken from UNO.  Runs of ASCII are converted in blocks with SSE2 or,
+ * when the CPU supports it, AVX2; everything else goes through the scalar
+ * code.  Malformed input (which only ByteStrings can contain) and unpaired
+ * surrogates are replaced with U+FFFD.
+ */
+
+namespace {
+
+typedef sal_Int32 (* Utf8ToUtf16) (unsigned char const *, sal_Int32, sal_Unicode *);
+typedef sal_Int32 (* Utf16ToUtf8) (sal_Unicode const *, sal_Int32, unsigned char *);
+
+// Decode one code point, returning the number of UTF-16 units written.
+inline sal_Int32 decodeUtf8 (unsigned char const * & src,
+    unsigned char const * end, sal_Unicode * dst)
+{
+  sal_uInt32 c = *src++;
+  if (c < 0x80) {
+    dst[0] = c;
+    return 1;
+  }
+  int n;
+  sal_uInt32 min;
+  if (c >= 0xC2 && c <= 0xDF) {
+    n = 1; c &= 0x1F; min = 0x80;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    n = 2; c &= 0x0F; min = 0x800;
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    n = 3; c &= 0x07; min = 0x10000;
+  } else {
+    dst[0] = 0xFFFD;
+    return 1;
+  }
+  for (; n > 0; --n) {
+    if (src == end || (*src & 0xC0) != 0x80) {
+      dst[0] = 0xFFFD;
+      return 1;
+    }
+    c = (c << 6) | (*src++ & 0x3F);
+  }
+  if (c < min || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) {
+    dst[0] = 0xFFFD;
+    return 1;
+  }
+  if (c < 0x10000) {
+    dst[0] = c;
+    return 1;
+  }
+  c -= 0x10000;
+  dst[0] = 0xD800 | (c >> 10);
+  dst[1] = 0xDC00 | (c & 0x3FF);
+  return 2;
+}
+
+// Encode one code point, returning the number of bytes written.
+inline sal_Int32 encodeUtf8 (sal_Unicode const * & src,
+    sal_Unicode const * end, unsigned char * dst)
+{
+  sal_uInt32 c = *src++;
+  if (c < 0x80) {
+    dst[0] = c;
+    return 1;
+  }
+  if (c < 0x800) {
+    dst[0] = 0xC0 | (c >> 6);
+    dst[1] = 0x80 | (c & 0x3F);
+    return 2;
+  }
+  if (c >= 0xD800 && c <= 0xDBFF && src != end
+      && *src >= 0xDC00 && *src <= 0xDFFF)
+  {
+    c = 0x10000 + ((c - 0xD800) << 10) + (*src++ - 0xDC00);
+    dst[0] = 0xF0 | (c >> 18);
+    dst[1] = 0x80 | ((c >> 12) & 0x3F);
+    dst[2] = 0x80 | ((c >> 6) & 0x3F);
+    dst[3] = 0x80 | (c & 0x3F);
+    return 4;
+  }
+  if (c >= 0xD800 && c <= 0xDFFF)
+    c = 0xFFFD;
+  dst[0] = 0xE0 | (c >> 12);
+  dst[1] = 0x80 | ((c >> 6) & 0x3F);
+  dst[2] = 0x80 | (c & 0x3F);
+  return 3;
+}
+
+sal_Int32 utf8ToUtf16Scalar (unsigned char const * src, sal_Int32 len,
+    sal_Unicode * dst)
+{
+  unsigned char const * end = src + len;
+  sal_Unicode * out = dst;
+  while (src != end)
+    out += decodeUtf8(src, end, out);
+  return out - dst;
+}
+
+sal_Int32 utf16ToUtf8Scalar (sal_Unicode const * src, sal_Int32 len,
+    unsigned char * dst)
+{
+  sal_Unicode const * end = src + len;
+  unsigned char * out = dst;
+  while (src != end)
+    out += encodeUtf8(src, end, out);
+  return out - dst;
+}
+
+#ifdef HSUNO_TEXT_X86
+
+sal_Int32 utf8ToUtf16Sse2 (unsigned char const * src, sal_Int32 len,
+    sal_Unicode * dst)
+{
+  unsigned char const * end = src + len;
+  sal_Unicode * out = dst;
+  __m128i const zero = _mm_setzero_si128();
+  while (src != end) {
+    while (end - src >= 16) {
+      __m128i bytes = _mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(src));
+      if (_mm_movemask_epi8(bytes) != 0)
+        break;
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+          _mm_unpacklo_epi8(bytes, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8),
+          _mm_unpackhi_epi8(bytes, zero));
+      src += 16;
+      out += 16;
+    }
+    if (src != end)
+      out += decodeUtf8(src, end, out);
+  }
+  return out - dst;
+}
+
+sal_Int32 utf16ToUtf8Sse2 (sal_Unicode const * src, sal_Int32 len,
+    unsigned char * dst)
+{
+  sal_Unicode const * end = src + len;
+  unsigned char * out = dst;
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+  while (src != end) {
+    while (end - src >= 16) {
+      __m128i lo = _mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(src));
+      __m128i hi = _mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(src + 8));
+      __m128i high = _mm_and_si128(_mm_or_si128(lo, hi), nonAscii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF)
+        break;
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+          _mm_packus_epi16(lo, hi));
+      src += 16;
+      out += 16;
+    }
+    if (src != end)
+      out += encodeUtf8(src, end, out);
+  }
+  return out - dst;
+}
+
+__attribute__((target("avx2")))
+sal_Int32 utf8ToUtf16Avx2 (unsigned char const * src, sal_Int32 len,
+    sal_Unicode * dst)
+{
+  unsigned char const * end = src + len;
+  sal_Unicode * out = dst;
+  while (src != end) {
+    while (end - src >= 32) {
+      __m256i bytes = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const *>(src));
+      if (_mm256_movemask_epi8(bytes) != 0)
+        break;
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+          _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 16),
+          _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+      src += 32;
+      out += 32;
+    }
+    if (src != end)
+      out += decodeUtf8(src, end, out);
+  }
+  return out - dst;
+}
+
+__attribute__((target("avx2")))
+sal_Int32 utf16ToUtf8Avx2 (sal_Unicode const * src, sal_Int32 len,
+    unsigned char * dst)
+{
+  sal_Unicode const * end = src + len;
+  unsigned char * out = dst;
+  __m256i const nonAscii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+  while (src != end) {
+    while (end - src >= 32) {
+      __m256i lo = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const *>(src));
+      __m256i hi = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const *>(src + 16));
+      if (!_mm256_testz_si256(_mm256_or_si256(lo, hi), nonAscii))
+        break;
+      // packing works per 128 bit lane, so the quadwords are reordered
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+          _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+            0xD8));
+      src += 32;
+      out += 32;
+    }
+    if (src != end)
+      out += encodeUtf8(src, end, out);
+  }
+  return out - dst;
+}
+
+#endif // HSUNO_TEXT_X86
+
+struct Transcoders {
+  Utf8ToUtf16 toUtf16;
+  Utf16ToUtf8 toUtf8;
+};
+
+Transcoders selectTranscoders () {
+#ifdef HSUNO_TEXT_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    Transcoders t = { utf8ToUtf16Avx2, utf16ToUtf8Avx2 };
+    return t;
+  }
+  Transcoders t = { utf8ToUtf16Sse2, utf16ToUtf8Sse2 };
+  return t;
+#else
+  Transcoders t = { utf8ToUtf16Scalar, utf16ToUtf8Scalar };
+  return t;
+#endif
+}
+
+Transcoders const transcoders = selectTranscoders();
+
+}
+
 extern "C" {
 
 // FIXME This can be written directly in Haskell.
 rtl_uString * hsuno_uString_new (sal_Unicode * buf, sal_Int32 len) {
     rtl_uString * str = 0;
     rtl_uString_newFromStr_WithLength(&str, buf, len);
+    hsunoAccountingCount(HSUNO_COUNT_USTRING_CREATED);
     return str;
 }
 
+rtl_uString * hsuno_uString_newFromUtf8 (char const * buf, sal_Int32 len) {
+  // a UTF-8 sequence is never shorter than its UTF-16 counterpart, so the
+  // string is allocated at its largest size and decoded in one pass
+  rtl_uString * str = rtl_uString_alloc(len);
+  str->length = transcoders.toUtf16(
+      reinterpret_cast<unsigned char const *>(buf), len, str->buffer);
+  str->buffer[str->length] = 0;
+  hsunoAccountingCount(HSUNO_COUNT_USTRING_CREATED);
+  return str;
+}
+
+sal_Int32 hsuno_uString_toUtf8 (rtl_uString * str, char * buf) {
+  return transcoders.toUtf8(str->buffer, str->length,
+      reinterpret_cast<unsigned char *>(buf));
+}
+
+void hsuno_uString_release (rtl_uString * str) {
+  hsunoAccountingCount(HSUNO_COUNT_USTRING_FREED);
+  rtl_uString_release(str);
+}
+
 }
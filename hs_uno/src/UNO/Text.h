@@ -17,4 +17,19 @@ rtl_uString * oustringGetUString (OUString * str);
 extern "C"
 OUString * oustringFromUString (rtl_uString * ustr);
 
+/** Create an UString from UTF-8 text.
+ *
+ * Malformed input is replaced with U+FFFD.
+ */
+extern "C"
+rtl_uString * hsuno_uString_newFromUtf8 (char const * buf, sal_Int32 len);
+
+/** Write an UString as UTF-8 text.
+ *
+ * The buffer must hold at least three bytes per UTF-16 unit of the string.
+ * Returns the number of bytes written.
+ */
+extern "C"
+sal_Int32 hsuno_uString_toUtf8 (rtl_uString * str, char * buf);
+
 #endif // HSUNO_UNO_TEXT_H
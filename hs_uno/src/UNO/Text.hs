@@ -1,24 +1,45 @@
+{-# LANGUAGE CPP, MagicHash, UnliftedFFITypes #-}
 module UNO.Text where
 
+import           Control.Exception (bracket)
+import           Data.ByteString (ByteString)
+import qualified Data.ByteString.Internal as BI (createAndTrim)
+import qualified Data.ByteString.Unsafe as BU (unsafeUseAsCStringLen)
 import           Data.Int
+import           Data.IORef
+import           Data.Map (Map)
+import qualified Data.Map as Map
+import           Data.String (IsString (..))
 import           Data.Text (Text)
+import qualified Data.Text as T (pack)
 import qualified Data.Text.Foreign as T (fromPtr, useAsPtr)
 import           Data.Word
+import           Foreign.C.String (CString)
+import           Foreign.ForeignPtr
 import           Foreign.Ptr
+import           System.IO.Unsafe (unsafePerformIO)
+#if MIN_VERSION_text(2,0,0)
+import           Control.Monad.ST (RealWorld, stToIO)
+import           Control.Monad.ST.Unsafe (unsafeIOToST)
+import qualified Data.Text.Array as A
+import           Data.Text.Internal (Text (..))
+import           GHC.Exts (MutableByteArray#)
+#endif
 
 data OUString
 
 type OUStringPtr = Ptr OUString
 
 hs_text_to_oustring :: Text -> IO (Ptr OUString)
+#if MIN_VERSION_text(2,0,0)
+hs_text_to_oustring text = c_oustringFromUString =<< uStringNew text
+#else
 hs_text_to_oustring text = T.useAsPtr text
   $ \ buf len -> c_oustring_new buf (fromIntegral len)
+#endif
 
 hs_oustring_to_text :: Ptr OUString -> IO Text
-hs_oustring_to_text oustrPtr = do
-  buf <- c_oustring_buffer oustrPtr
-  len <- c_oustring_length oustrPtr
-  T.fromPtr buf (fromIntegral len)
+hs_oustring_to_text oustrPtr = uStringToText =<< c_oustringGetUString oustrPtr
 
 peekOUString :: Ptr OUString -> IO Text
 peekOUString = hs_oustring_to_text
@@ -29,40 +50,74 @@ oustringToUString = c_oustringGetUString
 ustringToOUString :: Ptr UString -> IO (Ptr OUString)
 ustringToOUString = c_oustringFromUString
 
-foreign import ccall "create_oustring" c_oustring_new
+foreign import ccall unsafe "create_oustring" c_oustring_new
   :: Ptr Word16 -> Int32 -> IO (Ptr OUString)
 
 -- void delete_oustring (OUString * str);
-foreign import ccall "delete_oustring" c_delete_oustring
+foreign import ccall unsafe "delete_oustring" c_delete_oustring
   :: Ptr OUString -> IO ()
 
-foreign import ccall "oustring_buffer" c_oustring_buffer
+foreign import ccall unsafe "oustring_buffer" c_oustring_buffer
   :: Ptr OUString -> IO (Ptr Word16)
 
-foreign import ccall "oustring_length" c_oustring_length
+foreign import ccall unsafe "oustring_length" c_oustring_length
   :: Ptr OUString -> IO Int32
 
 -- rtl_uString * oustringGetUString (OUString * str);
-foreign import ccall "oustringGetUString" c_oustringGetUString
+foreign import ccall unsafe "oustringGetUString" c_oustringGetUString
   :: Ptr OUString -> IO (Ptr UString)
 
 -- OUString * oustringFromUString (rtl_uString * ustr);
-foreign import ccall "oustringFromUString" c_oustringFromUString
+foreign import ccall unsafe "oustringFromUString" c_oustringFromUString
   :: Ptr UString -> IO (Ptr OUString)
 
 -- *UString
 
 data UString
 
+-- Texts are UTF-8 since text-2.0 and are transcoded to and from UTF-16;
+-- older versions share the representation of UStrings and are copied as is.
+
 uStringNew :: Text -> IO (Ptr UString)
+#if MIN_VERSION_text(2,0,0)
+uStringNew text = T.useAsPtr text
+  $ \ buf len -> hsuno_uString_newFromUtf8 (castPtr buf) (fromIntegral len)
+#else
 uStringNew text = T.useAsPtr text
   $ \ buf len -> hsuno_uString_new buf (fromIntegral len)
+#endif
 
 uStringToText :: Ptr UString -> IO Text
+#if MIN_VERSION_text(2,0,0)
+-- the text's array is allocated at its largest size, written in place and
+-- shrunk to the bytes written
+uStringToText ustrPtr = do
+  len <- uStringGetLength ustrPtr
+  stToIO $ do
+    marr@(A.MutableByteArray mba) <- A.new (3 * fromIntegral len)
+    size <- fmap fromIntegral
+              (unsafeIOToST (hsuno_uString_toUtf8Array ustrPtr mba))
+    A.shrinkM marr size
+    arr <- A.unsafeFreeze marr
+    return (Text arr 0 size)
+#else
 uStringToText ustrPtr = do
   buf <- uStringGetStr ustrPtr
   len <- uStringGetLength ustrPtr
   T.fromPtr buf (fromIntegral len)
+#endif
+
+-- |Create an UString from UTF-8 text; malformed input is replaced with
+-- U+FFFD.
+uStringFromUtf8 :: ByteString -> IO (Ptr UString)
+uStringFromUtf8 bytes = BU.unsafeUseAsCStringLen bytes
+  $ \ (buf, len) -> hsuno_uString_newFromUtf8 buf (fromIntegral len)
+
+uStringToUtf8 :: Ptr UString -> IO ByteString
+uStringToUtf8 ustrPtr = do
+  len <- uStringGetLength ustrPtr
+  BI.createAndTrim (3 * fromIntegral len) $ \ buf ->
+    fmap fromIntegral (hsuno_uString_toUtf8 ustrPtr (castPtr buf))
 
 withUString :: Text -> (Ptr UString -> IO a) -> IO a
 withUString text f = do
@@ -72,17 +127,129 @@ withUString text f = do
   uStringRelease pUString
   return ret
 
+-- *UString references
+
+-- |A reference to an UString, released when it is no longer used.
+--
+-- The characters stay in the UString, so a result that is only compared or
+-- passed on is never copied.
+newtype UStringRef = UStringRef (ForeignPtr UString)
+
+-- |Take over an acquired UString.
+adoptUString :: Ptr UString -> IO UStringRef
+adoptUString pUString = fmap UStringRef (newForeignPtr uStringReleasePtr pUString)
+
+withUStringRef :: UStringRef -> (Ptr UString -> IO a) -> IO a
+withUStringRef (UStringRef fpUString) = withForeignPtr fpUString
+
+-- |Copy the characters of an UString reference.
+uStringRefToText :: UStringRef -> IO Text
+uStringRefToText ref = withUStringRef ref uStringToText
+
+uStringRefLength :: UStringRef -> IO Int
+uStringRefLength ref = fmap fromIntegral (withUStringRef ref uStringGetLength)
+
+-- |Compare the characters of two UString references.
+uStringRefEquals :: UStringRef -> UStringRef -> IO Bool
+uStringRefEquals ref1 ref2 =
+  withUStringRef ref1 $ \ pUString1 ->
+    withUStringRef ref2 $ \ pUString2 ->
+      uStringEquals pUString1 pUString2
+
+-- |Compare the characters of an UString reference with a text.
+uStringRefEqualsText :: UStringRef -> Text -> IO Bool
+uStringRefEqualsText ref text =
+  withUStringRef ref $ \ pUString1 ->
+    withUStringArg text $ \ pUString2 ->
+      uStringEquals pUString1 pUString2
+
+uStringEquals :: Ptr UString -> Ptr UString -> IO Bool
+uStringEquals pUString1 pUString2
+  | pUString1 == pUString2 = return True
+  | otherwise = do
+      len1 <- uStringGetLength pUString1
+      len2 <- uStringGetLength pUString2
+      if len1 /= len2
+        then return False
+        else do
+          buf1 <- uStringGetStr pUString1
+          buf2 <- uStringGetStr pUString2
+          fmap (== 0) (ustrCompareWithLength buf1 len1 buf2 len2)
+
+-- *Interned UStrings
+
+-- |An interned, immutable UString.
+--
+-- Interned strings are created once per distinct text and live for the
+-- lifetime of the process; with OverloadedStrings a literal can be used
+-- wherever a constant is expected.
+newtype UStringConstant = UStringConstant (Ptr UString)
+
+instance IsString UStringConstant where
+  fromString = UStringConstant . unsafePerformIO . internUString . T.pack
+
+-- |Get the interned UString of a text, creating it on first use.
+internUString :: Text -> IO (Ptr UString)
+internUString text = do
+  table <- readIORef internTable
+  case Map.lookup text table of
+    Just pUString -> return pUString
+    Nothing -> do
+      pUString <- uStringNew text
+      (pInterned, isNew) <- atomicModifyIORef' internTable $ \ table' ->
+        case Map.lookup text table' of
+          Just pUString' -> (table', (pUString', False))
+          Nothing        -> (Map.insert text pUString table', (pUString, True))
+      if isNew then return () else uStringRelease pUString
+      return pInterned
+
+-- |Intern a text as a constant.
+internText :: Text -> IO UStringConstant
+internText text = fmap UStringConstant (internUString text)
+
+uStringConstantPtr :: UStringConstant -> Ptr UString
+uStringConstantPtr (UStringConstant pUString) = pUString
+
+-- |Pass a text as an UString argument to a call.
+--
+-- Texts that have been interned are passed without copying; any other text
+-- is copied into a temporary UString that is released when the call returns.
+withUStringArg :: Text -> (Ptr UString -> IO a) -> IO a
+withUStringArg text f = do
+  table <- readIORef internTable
+  case Map.lookup text table of
+    Just pUString -> f pUString
+    Nothing       -> bracket (uStringNew text) uStringRelease f
+
+{-# NOINLINE internTable #-}
+internTable :: IORef (Map Text (Ptr UString))
+internTable = unsafePerformIO (newIORef Map.empty)
+
 foreign import ccall unsafe "hsuno_uString_new" hsuno_uString_new
   :: Ptr Word16 -> Int32 -> IO (Ptr UString)
 
+foreign import ccall unsafe "hsuno_uString_newFromUtf8" hsuno_uString_newFromUtf8
+  :: CString -> Int32 -> IO (Ptr UString)
+
+foreign import ccall unsafe "hsuno_uString_toUtf8" hsuno_uString_toUtf8
+  :: Ptr UString -> CString -> IO Int32
+
+#if MIN_VERSION_text(2,0,0)
+foreign import ccall unsafe "hsuno_uString_toUtf8" hsuno_uString_toUtf8Array
+  :: Ptr UString -> MutableByteArray# RealWorld -> IO Int32
+#endif
+
 foreign import ccall unsafe "rtl_uString_getLength" uStringGetLength
   :: Ptr UString -> IO Int32
 
 foreign import ccall unsafe "rtl_uString_getStr" uStringGetStr
   :: Ptr UString -> IO (Ptr Word16)
 
-foreign import ccall unsafe "rtl_uString_release" uStringRelease
+foreign import ccall unsafe "hsuno_uString_release" uStringRelease
   :: Ptr UString -> IO ()
 
-foreign import ccall unsafe "&rtl_uString_release" uStringReleasePtr
+foreign import ccall unsafe "&hsuno_uString_release" uStringReleasePtr
   :: FunPtr (Ptr UString -> IO ())
+
+foreign import ccall unsafe "rtl_ustr_compare_WithLength" ustrCompareWithLength
+  :: Ptr Word16 -> Int32 -> Ptr Word16 -> Int32 -> IO Int32
@@ -22,4 +22,33 @@ typelib_TypeDescription * hsuno_getTypeDescriptionByName (rtl::OUString const *
     return td;
 }
 
+extern "C"
+rtl_uString * hsuno_typeref_getName (
+    typelib_TypeDescriptionReference const * pType)
+{
+    return pType->pTypeName;
+}
+
+extern "C"
+sal_Bool hsuno_struct_checkLayout (rtl_uString * pName, sal_Int32 nSize,
+    sal_Int32 nMembers, sal_Int32 const * pOffsets)
+{
+    typelib_TypeDescription * td = 0;
+    typelib_typedescription_getByName(&td, pName);
+    if (td == 0)
+        return false;
+    if (!td->bComplete)
+        typelib_typedescription_complete(&td);
+    bool ok = td->eTypeClass == typelib_TypeClass_STRUCT && td->nSize == nSize;
+    if (ok) {
+        typelib_CompoundTypeDescription * ctd =
+            reinterpret_cast< typelib_CompoundTypeDescription * >(td);
+        ok = ctd->pBaseTypeDescription == 0 && ctd->nMembers == nMembers;
+        for (sal_Int32 i = 0; ok && i < nMembers; ++i)
+            ok = ctd->pMemberOffsets[i] == pOffsets[i];
+    }
+    typelib_typedescription_release(td);
+    return ok;
+}
+
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
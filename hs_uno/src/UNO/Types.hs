@@ -1,14 +1,20 @@
 {-# LANGUAGE ScopedTypeVariables, OverloadedStrings #-}
 {-# LANGUAGE MultiParamTypeClasses, FunctionalDependencies #-}
 {-# LANGUAGE FlexibleInstances #-}
+{-# LANGUAGE GeneralizedNewtypeDeriving #-}
 module UNO.Types where
 
 import UNO.Text
 
+import Control.Monad (when)
 import Data.Int
-import Data.Text (Text)
+import Data.IORef
+import Data.Map (Map)
+import qualified Data.Map as Map
+import Data.Text (Text, unpack)
 import qualified Data.Text as T (append)
 import Foreign
+import System.IO.Unsafe (unsafePerformIO)
 
 data CSequence a
 
@@ -64,6 +70,28 @@ instance IsUnoType Double where
   getUnoTypeClass _ = Typelib_TypeClass_DOUBLE
   getUnoTypeName  _ = "double"
 
+-- |A UNO boolean as stored in memory (one byte), e.g. in sequences.
+newtype UnoBoolean = UnoBoolean Word8
+  deriving (Eq, Ord, Show, Storable)
+
+instance IsUnoType UnoBoolean where
+  getUnoTypeClass _ = Typelib_TypeClass_BOOLEAN
+  getUnoTypeName  _ = "boolean"
+
+fromUnoBoolean :: UnoBoolean -> Bool
+fromUnoBoolean (UnoBoolean b) = b /= 0
+
+toUnoBoolean :: Bool -> UnoBoolean
+toUnoBoolean b = UnoBoolean (if b then 1 else 0)
+
+-- |A UNO char (a UTF-16 code unit) as stored in memory.
+newtype UnoChar = UnoChar Word16
+  deriving (Eq, Ord, Show, Storable)
+
+instance IsUnoType UnoChar where
+  getUnoTypeClass _ = Typelib_TypeClass_CHAR
+  getUnoTypeName  _ = "char"
+
 instance IsUnoType UString where
   getUnoTypeClass _ = Typelib_TypeClass_STRING
   getUnoTypeName  _ = "string"
@@ -126,12 +154,49 @@ data TypeDescription
 
 type TypeDescriptionPtr = ForeignPtr TypeDescription
 
+-- |Get the type description of a type by its name.
+--
+-- Descriptions are cached for the lifetime of the process, so the same
+-- description is shared by every lookup of a given name.
 getTypeDescription :: Text -> IO TypeDescriptionPtr
 getTypeDescription name = do
+  cache <- readIORef typeDescriptionCache
+  case Map.lookup name cache of
+    Just fpTD -> do
+      atomicModifyIORef' typeDescriptionCacheStats $ \ (h, m) -> ((h + 1, m), ())
+      return fpTD
+    Nothing -> do
+      atomicModifyIORef' typeDescriptionCacheStats $ \ (h, m) -> ((h, m + 1), ())
+      fpTD <- lookupTypeDescription name
+      atomicModifyIORef' typeDescriptionCache $ \ cache' ->
+        case Map.lookup name cache' of
+          Just fpTD' -> (cache', fpTD')
+          Nothing    -> (Map.insert name fpTD cache', fpTD)
+
+-- |The type description of a type, for top-level constants of generated
+-- code, which look it up once.
+typeDescriptionConstant :: Text -> TypeDescriptionPtr
+typeDescriptionConstant name = unsafePerformIO (getTypeDescription name)
+{-# NOINLINE typeDescriptionConstant #-}
+
+-- |Number of hits and misses of the type description cache.
+getTypeDescriptionCacheStats :: IO (Int, Int)
+getTypeDescriptionCacheStats = readIORef typeDescriptionCacheStats
+
+lookupTypeDescription :: Text -> IO TypeDescriptionPtr
+lookupTypeDescription name = do
   psName <- hs_text_to_oustring name
   ptr <- cGetTypeDescriptionByName psName
   c_delete_oustring psName
   newForeignPtr typelib_typedescription_release ptr
+
+{-# NOINLINE typeDescriptionCache #-}
+typeDescriptionCache :: IORef (Map Text TypeDescriptionPtr)
+typeDescriptionCache = unsafePerformIO (newIORef Map.empty)
+
+{-# NOINLINE typeDescriptionCacheStats #-}
+typeDescriptionCacheStats :: IORef (Int, Int)
+typeDescriptionCacheStats = unsafePerformIO (newIORef (0, 0))
 {-
 getTypeDescription :: TypeClass -> Text -> IO TypeDescriptionPtr
 getTypeDescription tc t = do
@@ -151,12 +216,36 @@ foreign import ccall "css_uno_Type_getDescription"
 foreign import ccall "&typelib_typedescription_release"
   typelib_typedescription_release :: FunPtr (Ptr TypeDescription -> IO ())
 
-foreign import ccall "typelib_typedescription_getSize"
+foreign import ccall unsafe "typelib_typedescription_getSize"
   typelib_typedescription_getSize :: Ptr TypeDescription -> IO Int32
 
 foreign import ccall "hsuno_getTypeDescriptionByName"
   cGetTypeDescriptionByName :: Ptr OUString -> IO (Ptr TypeDescription)
 
+-- *Struct Layout
+
+-- |Check that a struct is laid out in memory with the given size and member
+-- offsets, as generated Storable instances assume.
+checkStructLayout :: Text -> Int -> [Int] -> IO ()
+checkStructLayout name size offsets =
+  withUStringArg name $ \ pName ->
+    withArrayLen (map fromIntegral offsets) $ \ n pOffsets -> do
+      ok <- cStructCheckLayout pName (fromIntegral size) (fromIntegral n)
+              pOffsets
+      when (ok == 0) $
+        error ("unexpected memory layout of struct " ++ unpack name)
+
+-- |Check the layout of a struct when first forced.  Generated bindings bind
+-- it to a top-level constant that their Storable instances force, so that
+-- the check is made once per process, on the first peek or poke of the
+-- struct; a mismatch is raised there and not at bootstrap.
+structLayoutChecked :: Text -> Int -> [Int] -> ()
+structLayoutChecked name size offsets =
+  unsafePerformIO (checkStructLayout name size offsets)
+
+foreign import ccall "hsuno_struct_checkLayout" cStructCheckLayout
+  :: Ptr UString -> Int32 -> Int32 -> Ptr Int32 -> IO Word8
+
 -- |This type class enum is binary compatible with the IDL enum com.sun.star.uno.TypeClass.
 --
 -- (from 'include/typelib/typeclass.h': typedef enum _typelib_TypeClass)
@@ -230,3 +319,7 @@ data TypeClass
 -- *Type Description Reference
 
 data TypeDescriptionReference
+
+-- |The name of a referenced type (owned by the reference).
+foreign import ccall unsafe "hsuno_typeref_getName" typeRefGetName
+  :: Ptr TypeDescriptionReference -> IO (Ptr UString)
@@ -16,25 +16,62 @@
 #include "unoidl/unoidl.hxx"
 
 #include "module.hxx"
+#include "types.hxx"
 
 struct Entity : public salhelper::SimpleReferenceObject {
+    // the type name is interned, and split into its path once
+    Entity (rtl::OUString const & type,
+            rtl::Reference< unoidl::Entity > const & unoidl
+                = rtl::Reference< unoidl::Entity >())
+        : unoidl(unoidl), type(type.intern()), path(type) {};
+
     rtl::Reference< unoidl::Entity > unoidl;
-    rtl::OUString type;
+    const rtl::OUString type;
+    const Module path;
     std::set< rtl::OUString > interfaces;
     std::set< rtl::OUString > dependencies;
 
     inline Module getModule () const {
-        return Module(type).getParent();
+        return path.getParent();
     }
 
     inline rtl::OUString getName () const {
-        return Module(type).getLastName();
+        return path.getLastName();
     }
 
     inline bool isStruct () const {
         return unoidl->getSort() == unoidl::Entity::SORT_PLAIN_STRUCT_TYPE;
     }
 
+    // plain structs without a base whose members are all of basic types,
+    // which Haskell code reads and writes in place
+    inline bool isFlatStruct () const {
+        if (!isStruct())
+            return false;
+        rtl::Reference< unoidl::PlainStructTypeEntity > ent (
+                static_cast< unoidl::PlainStructTypeEntity * >(unoidl.get()));
+        if (!ent->getDirectBase().isEmpty())
+            return false;
+        std::vector< unoidl::PlainStructTypeEntity::Member > members (
+                ent->getDirectMembers());
+        if (members.empty())
+            return false;
+        for (std::vector< unoidl::PlainStructTypeEntity::Member >::const_iterator
+                it (members.begin()) ; it != members.end() ; ++it)
+            if (!isBasicType(it->type) || it->type == "void")
+                return false;
+        return true;
+    }
+
+    inline bool isEnum () const {
+        return unoidl->getSort() == unoidl::Entity::SORT_ENUM_TYPE;
+    }
+
+    // types with Storable instances, passed to and from C++ by pointer
+    inline bool isStorable () const {
+        return isEnum() || isFlatStruct();
+    }
+
     inline bool isInterface () const {
         return unoidl->getSort() == unoidl::Entity::SORT_INTERFACE_TYPE;
     }
@@ -44,7 +81,5 @@ typedef rtl::Reference< Entity > EntityRef;
 
 typedef std::map< rtl::OUString, EntityRef > EntityList;
 
-typedef std::map< rtl::OUString, EntityList > ModuleList;
-
 #endif /* HSUNOIDL_ENTITY_HXX */
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
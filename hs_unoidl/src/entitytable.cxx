@@ -0,0 +1,93 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of the LibreOffice project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "entitytable.hxx"
+
+#include <map>
+
+using rtl::OUString;
+
+EntityTable::EntityTable (EntityList const & list) {
+    entities.reserve(list.size());
+    kinds.reserve(list.size());
+    indices.reserve(list.size());
+    // modules by name, so that they are written in order
+    std::map< OUString, sal_Int32 > moduleIndices;
+    for (EntityList::const_iterator it (list.begin()) ; it != list.end() ;
+            ++it)
+    {
+        EntityRef const & entity (it->second);
+        sal_Int32 index = static_cast< sal_Int32 >(entities.size());
+        entities.push_back(entity);
+        unsigned char kind = 0;
+        if (entity->isInterface())
+            kind |= KIND_INTERFACE;
+        if (entity->isEnum())
+            kind |= KIND_ENUM;
+        if (entity->isFlatStruct())
+            kind |= KIND_FLAT_STRUCT;
+        kinds.push_back(kind);
+        indices[entity->type] = index;
+
+        Module module (entity->getModule());
+        OUString moduleName (module.getName());
+        std::map< OUString, sal_Int32 >::const_iterator m (
+                moduleIndices.find(moduleName));
+        if (m == moduleIndices.end()) {
+            m = moduleIndices.insert(std::make_pair(moduleName,
+                        static_cast< sal_Int32 >(modules.size()))).first;
+            modules.push_back(ModuleEntry());
+            modules.back().module = new Entity(moduleName);
+        }
+        modules[m->second].members.push_back(index);
+    }
+    // the entries were appended in order of their first entity, which for
+    // nested modules is not the order of their names
+    std::vector< ModuleEntry > sorted;
+    sorted.reserve(modules.size());
+    for (std::map< OUString, sal_Int32 >::const_iterator it (
+                moduleIndices.begin()) ; it != moduleIndices.end() ; ++it)
+        sorted.push_back(modules[it->second]);
+    modules.swap(sorted);
+}
+
+sal_Int32 EntityTable::find (OUString const & type) const {
+    std::unordered_map< OUString, sal_Int32, rtl::OUStringHash
+        >::const_iterator it (indices.find(type));
+    return it == indices.end() ? -1 : it->second;
+}
+
+OUString EntityTable::resolveTypedef (OUString const & type) const {
+    OUString resolved (type);
+    for (;;) {
+        sal_Int32 index = find(resolved);
+        if (index < 0 || entities[index]->unoidl->getSort()
+                != unoidl::Entity::SORT_TYPEDEF)
+            return resolved;
+        resolved = static_cast< unoidl::TypedefEntity * >(
+                entities[index]->unoidl.get())->getType();
+    }
+}
+
+Module const & EntityTable::getPath (OUString const & type) const {
+    sal_Int32 index = find(type);
+    if (index >= 0)
+        return entities[index]->path;
+    std::unordered_map< OUString, Module, rtl::OUStringHash >::iterator it (
+            otherPaths.find(type));
+    if (it == otherPaths.end())
+        it = otherPaths.insert(std::make_pair(type, Module(type))).first;
+    return it->second;
+}
+
+EntityTable const & EntityTable::empty () {
+    static EntityTable table;
+    return table;
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
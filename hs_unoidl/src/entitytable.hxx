@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of the LibreOffice project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef HSUNOIDL_ENTITYTABLE_HXX
+#define HSUNOIDL_ENTITYTABLE_HXX
+
+#include <unordered_map>
+#include <vector>
+
+#include "rtl/ustring.hxx"
+
+#include "entity.hxx"
+#include "module.hxx"
+
+/* All the entities code is generated for, built once when their dependencies
+ * are resolved and then only read.  The entities are kept in the order of
+ * their type names, and what the writers ask about a type (its sort, its
+ * path) is computed here once per entity.  Writers share the table by
+ * reference.
+ */
+class EntityTable {
+    public:
+        // the entities of one generated module, by index
+        struct ModuleEntry {
+            EntityRef module;
+            std::vector< sal_Int32 > members;
+        };
+
+        EntityTable () {};
+        explicit EntityTable (EntityList const & entities);
+
+        sal_Int32 size () const {
+            return static_cast< sal_Int32 >(entities.size());
+        };
+        EntityRef const & operator [] (sal_Int32 index) const {
+            return entities[index];
+        };
+        // the index of a type, or -1 if the table does not have it
+        sal_Int32 find (rtl::OUString const & type) const;
+
+        bool isInterface (rtl::OUString const & type) const {
+            return hasKind(type, KIND_INTERFACE);
+        };
+        bool isEnum (rtl::OUString const & type) const {
+            return hasKind(type, KIND_ENUM);
+        };
+        bool isFlatStruct (rtl::OUString const & type) const {
+            return hasKind(type, KIND_FLAT_STRUCT);
+        };
+        bool isStorable (rtl::OUString const & type) const {
+            return hasKind(type, KIND_ENUM | KIND_FLAT_STRUCT);
+        };
+        bool isFlatStruct (sal_Int32 index) const {
+            return (kinds[index] & KIND_FLAT_STRUCT) != 0;
+        };
+        bool isEnum (sal_Int32 index) const {
+            return (kinds[index] & KIND_ENUM) != 0;
+        };
+        bool isInterface (sal_Int32 index) const {
+            return (kinds[index] & KIND_INTERFACE) != 0;
+        };
+
+        // the type a typedef stands for, through typedefs of typedefs; other
+        // types, and types the table does not have, are returned as they are
+        rtl::OUString resolveTypedef (rtl::OUString const & type) const;
+
+        // the path of a type, split once per type; types outside the table
+        // are split on their first lookup
+        Module const & getPath (rtl::OUString const & type) const;
+
+        std::vector< ModuleEntry > const & getModules () const {
+            return modules;
+        };
+
+        // the table of writers that do not look up other types
+        static EntityTable const & empty ();
+    private:
+        enum {
+            KIND_INTERFACE = 1,
+            KIND_ENUM = 2,
+            KIND_FLAT_STRUCT = 4
+        };
+
+        bool hasKind (rtl::OUString const & type, unsigned char kind) const {
+            sal_Int32 index = find(type);
+            return index >= 0 && (kinds[index] & kind) != 0;
+        };
+
+        std::vector< EntityRef > entities;
+        std::vector< unsigned char > kinds;
+        std::unordered_map< rtl::OUString, sal_Int32, rtl::OUStringHash >
+            indices;
+        std::vector< ModuleEntry > modules;
+        // references into the map stay valid when it grows
+        mutable std::unordered_map< rtl::OUString, Module, rtl::OUStringHash >
+            otherPaths;
+
+        // shared, never copied
+        EntityTable (EntityTable const &);
+        EntityTable & operator = (EntityTable const &);
+};
+
+#endif /* HSUNOIDL_ENTITYTABLE_HXX */
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
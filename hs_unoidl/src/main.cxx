@@ -18,7 +18,9 @@
 #include <map>
 #include <set>
 
+#include "entitytable.hxx"
 #include "module.hxx"
+#include "options.hxx"
 #include "types.hxx"
 #include "writer.hxx"
 
@@ -27,12 +29,33 @@ using ::rtl::OUString;
 void badUsage () {
     std::cerr
         << "Usage:" << std::endl << std::endl
-        << "  hs_unoidl -Ttype1:type2:...:typeN <registry>..."
+        << "  hs_unoidl [options] -Ttype1:type2:...:typeN <registry>..."
         << std::endl << std::endl
         << ("where each <registry> is either a new- or legacy-format .rdb file,"
             " a single .idl")
         << std::endl
         << ("file, or a root directory of an .idl file tree.")
+        << std::endl << std::endl
+        << "Options:" << std::endl << std::endl
+        << ("  --dispatch=name      generated stubs resolve methods by name"
+            " (default)")
+        << std::endl
+        << ("  --dispatch=position  generated stubs resolve each interface"
+            " once and")
+        << std::endl
+        << "                       dispatch by member position" << std::endl
+        << ("  --ffi-default=<safe|unsafe|interruptible>")
+        << std::endl
+        << ("                       calling convention of the foreign imports"
+            " of")
+        << std::endl
+        << "                       interface methods (default: safe)"
+        << std::endl
+        << ("  --ffi-policy=<file>  per interface or method calling"
+            " conventions, one")
+        << std::endl
+        << ("                       \"<convention> <Iface|Iface::method>\""
+            " per line")
         << std::endl;
     std::exit(EXIT_FAILURE);
 }
@@ -174,6 +197,14 @@ std::set< OUString > findDependencies (
                 }
             }
             break;
+        case unoidl::Entity::SORT_TYPEDEF:
+            {
+                rtl::Reference< unoidl::TypedefEntity > ent2 (
+                        static_cast< unoidl::TypedefEntity * >(
+                            entity->unoidl.get()));
+                insertDependency(dependencies, entity, ent2->getType());
+            }
+            break;
         // TODO
     }
     return dependencies;
@@ -209,55 +240,52 @@ void updateImplementedInterfaces (
 }
 
 inline
-void generateCode (EntityList const & entities) {
-    for (EntityList::const_iterator it (entities.begin()) ;
-            it != entities.end() ; ++it)
-    {
-        switch (it->second->unoidl->getSort()) {
+void generateCode (EntityTable const & entities) {
+    for (sal_Int32 i = 0 ; i < entities.size() ; ++i) {
+        EntityRef const & entity (entities[i]);
+        switch (entity->unoidl->getSort()) {
             case unoidl::Entity::SORT_PLAIN_STRUCT_TYPE:
-                writePlainStruct(entities, it->second);
+                writePlainStruct(entities, entity);
                 break;
             case unoidl::Entity::SORT_EXCEPTION_TYPE:
-                writeException(it->second);
+                writeException(entity);
                 break;
             case unoidl::Entity::SORT_INTERFACE_TYPE:
                 // do not generate code for 'com.sun.star.uno.XInterface'
-                if (it->second->type != "com.sun.star.uno.XInterface")
-                    writeInterface(entities, it->second);
+                if (entity->type != "com.sun.star.uno.XInterface")
+                    writeInterface(entities, entity);
                 break;
             case unoidl::Entity::SORT_SINGLE_INTERFACE_BASED_SERVICE:
-                writeSingleInterfaceBasedService(entities, it->second);
+                writeSingleInterfaceBasedService(entities, entity);
+                break;
+            case unoidl::Entity::SORT_ACCUMULATION_BASED_SERVICE:
+                writeAccumulationBasedService(entities, entity);
                 break;
             case unoidl::Entity::SORT_INTERFACE_BASED_SINGLETON:
-                writeInterfaceBasedSingleton(entities, it->second);
+                writeInterfaceBasedSingleton(entities, entity);
+                break;
+            case unoidl::Entity::SORT_CONSTANT_GROUP:
+                writeConstantGroup(entity);
+                break;
+            case unoidl::Entity::SORT_ENUM_TYPE:
+            case unoidl::Entity::SORT_TYPEDEF:
+                // written with their module
                 break;
             default:
                 std::cout << "Warning: entity not yet supported ["
-                    << it->second->unoidl->getSort() << "]" << std::endl;
+                    << entity->unoidl->getSort() << "]" << std::endl;
                 break;
             // TODO
         }
     }
 }
 
-void generateModules (EntityList const & entities) {
-    ModuleList modules;
-    // populate modules
-    for (EntityList::const_iterator it (entities.begin()) ;
-            it != entities.end() ; ++it)
-    {
-        Module m (it->second->type);
-        modules[m.getParent().getName()].insert(
-                EntityList::value_type(it->second->type, it->second));
-    }
-    // write modules
-    for (ModuleList::const_iterator it (modules.begin()) ;
-            it != modules.end() ; ++it)
-    {
-        EntityRef entity = new Entity;
-        entity->type = it->first;
-        writeModule(modules, entity);
-    }
+void generateModules (EntityTable const & entities) {
+    std::vector< EntityTable::ModuleEntry > const & modules (
+            entities.getModules());
+    for (std::vector< EntityTable::ModuleEntry >::const_iterator it (
+                modules.begin()) ; it != modules.end() ; ++it)
+        writeModule(entities, *it);
 }
 
 SAL_IMPLEMENT_MAIN() {
@@ -271,7 +299,13 @@ SAL_IMPLEMENT_MAIN() {
         for (sal_uInt32 i = 0 ; i < args ; ++i) {
             OUString arg;
             rtl_getAppCommandArg(i, &arg.pData);
-            if (arg.compareTo("-T", 2) == 0) {
+            if (arg.compareTo("--", 2) == 0) {
+                if (!parseOption(arg)) {
+                    std::cerr << "Error: unknown option '" << arg << "'."
+                        << std::endl;
+                    badUsage();
+                }
+            } else if (arg.compareTo("-T", 2) == 0) {
                 sal_Int32 idx = 2;
                 do {
                     types.insert(arg.getToken(0, ':', idx));
@@ -300,9 +334,8 @@ SAL_IMPLEMENT_MAIN() {
         for (std::set< OUString >::const_iterator it (types.begin()) ;
                 it != types.end() ; ++it)
         {
-            rtl::Reference< Entity > entity (new Entity);
-            entity->unoidl = manager->findEntity(*it);
-            entity->type = *it;
+            rtl::Reference< Entity > entity (
+                    new Entity(*it, manager->findEntity(*it)));
             if (entity->unoidl.is()) {
                 entities.insert(std::pair< OUString, rtl::Reference< Entity > >
                         (entity->type, entity));
@@ -329,9 +362,8 @@ SAL_IMPLEMENT_MAIN() {
                     it != newTypes.end() ; ++it)
             {
                 if (notFound.count(*it) == 0 && entities.count(*it) == 0) {
-                    rtl::Reference< Entity > entity (new Entity);
-                    entity->unoidl = manager->findEntity(*it);
-                    entity->type = *it;
+                    rtl::Reference< Entity > entity (
+                            new Entity(*it, manager->findEntity(*it)));
                     if (entity->unoidl.is()) {
                         processing.insert(
                                 std::pair< OUString, rtl::Reference< Entity > >
@@ -346,10 +378,12 @@ SAL_IMPLEMENT_MAIN() {
         }
         // update implemented interfaces
         updateImplementedInterfaces(manager, entities);
+        // the table all writers share
+        const EntityTable table (entities);
         // generate code for each type
-        generateCode(entities);
+        generateCode(table);
         // generate code for each module
-        generateModules(entities);
+        generateModules(table);
         return EXIT_SUCCESS;
     } catch (unoidl::FileFormatException & e1) {
         std::cerr
@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of the LibreOffice project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "options.hxx"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "file.hxx"
+#include "osl/file.hxx"
+
+using rtl::OUString;
+
+Options options;
+
+bool parseFfiSafety (OUString const & str, FfiSafety & safety) {
+    if (str == "safe")
+        safety = FFI_SAFE;
+    else if (str == "unsafe")
+        safety = FFI_UNSAFE;
+    else if (str == "interruptible")
+        safety = FFI_INTERRUPTIBLE;
+    else
+        return false;
+    return true;
+}
+
+/** Read an FFI policy file.
+ *
+ * Each non-empty line that does not start with '#' has the form
+ *
+ *   <safe|unsafe|interruptible> <Iface|Iface::method>
+ */
+bool readFfiPolicy (OUString const & path) {
+    OUString sysPath;
+    osl::FileBase::getSystemPathFromFileURL(File::getFileUrlFromPath(path),
+            sysPath);
+    std::ifstream in (sysPath.toUtf8().getStr());
+    if (!in) {
+        std::cerr << "Cannot open FFI policy file \"" << path << "\""
+            << std::endl;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        OUString l (rtl::OStringToOUString(rtl::OString(line.c_str()),
+                    RTL_TEXTENCODING_UTF8).trim());
+        if (l.isEmpty() || l[0] == '#')
+            continue;
+        sal_Int32 idx = 0;
+        OUString convention (l.getToken(0, ' ', idx));
+        OUString target (idx >= 0 ? l.copy(idx).trim() : OUString());
+        FfiSafety safety;
+        if (target.isEmpty() || !parseFfiSafety(convention, safety)) {
+            std::cerr << path << ":" << lineNumber
+                << ": invalid FFI policy entry" << std::endl;
+            return false;
+        }
+        options.ffiPolicy[target] = safety;
+    }
+    return true;
+}
+
+bool parseOption (OUString const & arg) {
+    if (arg.startsWith("--ffi-default="))
+        return parseFfiSafety(arg.copy(14), options.ffiDefault);
+    if (arg.startsWith("--ffi-policy="))
+        return readFfiPolicy(arg.copy(13));
+    if (arg == "--dispatch=name") {
+        options.dispatch = DISPATCH_BY_NAME;
+        return true;
+    }
+    if (arg == "--dispatch=position") {
+        options.dispatch = DISPATCH_BY_POSITION;
+        return true;
+    }
+    return false;
+}
+
+FfiSafety ffiSafety (OUString const & iface, OUString const & member) {
+    std::map< OUString, FfiSafety >::const_iterator it (
+            options.ffiPolicy.find(iface + "::" + member));
+    if (it != options.ffiPolicy.end())
+        return it->second;
+    it = options.ffiPolicy.find(iface);
+    if (it != options.ffiPolicy.end())
+        return it->second;
+    return options.ffiDefault;
+}
+
+OUString ffiSafetyKeyword (FfiSafety safety) {
+    switch (safety) {
+        case FFI_UNSAFE:
+            return OUString("unsafe");
+        case FFI_INTERRUPTIBLE:
+            return OUString("interruptible");
+        default:
+            return OUString();
+    }
+}
+
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
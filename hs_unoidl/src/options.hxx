@@ -0,0 +1,53 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This file is part of the LibreOffice project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef HSUNOIDL_OPTIONS_HXX
+#define HSUNOIDL_OPTIONS_HXX
+
+#include <map>
+#include "rtl/ustring.hxx"
+
+enum DispatchMode {
+    // resolve "Iface::method" at runtime (makeBinaryUnoCall)
+    DISPATCH_BY_NAME,
+    // resolve the interface once and dispatch by member position
+    DISPATCH_BY_POSITION
+};
+
+enum FfiSafety {
+    FFI_SAFE,
+    FFI_UNSAFE,
+    FFI_INTERRUPTIBLE
+};
+
+struct Options {
+    Options () : dispatch(DISPATCH_BY_NAME), ffiDefault(FFI_SAFE) {};
+    DispatchMode dispatch;
+    // calling convention of the foreign imports of interface methods, by
+    // "Iface" or "Iface::method"
+    FfiSafety ffiDefault;
+    std::map< rtl::OUString, FfiSafety > ffiPolicy;
+};
+
+extern Options options;
+
+bool parseOption (rtl::OUString const & arg);
+
+/** Calling convention for a member of an interface.
+ *
+ * A policy entry for the member takes precedence over one for the interface,
+ * which takes precedence over the default.
+ */
+FfiSafety ffiSafety (rtl::OUString const & iface, rtl::OUString const & member);
+
+/** The foreign import keyword for a calling convention ("" when safe).
+ */
+rtl::OUString ffiSafetyKeyword (FfiSafety safety);
+
+#endif /* HSUNOIDL_OPTIONS_HXX */
+/* vim:set shiftwidth=4 softtabstop=4 expandtab: */
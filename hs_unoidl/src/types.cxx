@@ -10,6 +10,7 @@
 
 #include <iostream>
 
+#include "entitytable.hxx"
 #include "module.hxx"
 #include "utils.hxx"
 
@@ -54,6 +55,45 @@ bool isSequenceType (OUString const & type) {
     return (type.compareTo("[]", 2) == 0);
 }
 
+OUString toHsSequenceElementType (OUString const & type)
+{
+    if (type == "boolean") return OUString("UnoBoolean");
+    if (type == "byte") return OUString("Word8");
+    if (type == "short") return OUString("Int16");
+    if (type == "unsigned short") return OUString("Word16");
+    if (type == "long") return OUString("Int32");
+    if (type == "unsigned long") return OUString("Word32");
+    if (type == "hyper") return OUString("Int64");
+    if (type == "unsigned hyper") return OUString("Word64");
+    if (type == "float") return OUString("Float");
+    if (type == "double") return OUString("Double");
+    if (type == "char") return OUString("UnoChar");
+    return OUString();
+}
+
+bool isViewableSequenceType (OUString const & type)
+{
+    return (isSequenceType(type)
+            && !toHsSequenceElementType(type.copy(2)).isEmpty());
+}
+
+sal_Int32 basicTypeSize (OUString const & type)
+{
+    if (type == "boolean" || type == "byte") return 1;
+    if (type == "short" || type == "unsigned short" || type == "char") return 2;
+    if (type == "long" || type == "unsigned long" || type == "float") return 4;
+    if (type == "hyper" || type == "unsigned hyper" || type == "double")
+        return 8;
+    return 0;
+}
+
+OUString toHsStorableType (OUString const & type)
+{
+    if (type == "boolean") return OUString("Bool");
+    if (type == "char") return OUString("Word16");
+    return toHsSequenceElementType(type);
+}
+
 OUString toCppType (OUString const & name)
 {
     if (name.compareTo("hsuno ", 6) == 0)
@@ -81,7 +121,7 @@ OUString toCppType (OUString const & name)
     return result;
 }
 
-OUString toHsType (OUString const & name)
+OUString toHsType (EntityTable const & entities, OUString const & name)
 {
     if (name.compareTo("hsuno ", 6) == 0)
         return name.copy(6);
@@ -101,17 +141,18 @@ OUString toHsType (OUString const & name)
     if (name == "any") return OUString("Any");
     OUString result;
     if (name == "[]string") {
-        result = "[" + toHsType(name.copy(2)) + "]";
+        result = "[" + toHsType(entities, name.copy(2)) + "]";
+    } else if (isViewableSequenceType(name)) {
+        result = "(SequenceView " + toHsSequenceElementType(name.copy(2)) + ")";
     } else if (isSequenceType(name)) {
         result = "(Ptr (CSequence ()))";
-        //result = "(Ptr (CSequence " + toHsType(name.copy(2)) + "))";
     } else {
-        result = "(Reference " + Module(name).getNameCapitalized() + ")";
+        result = "(Reference " + entities.getPath(name).getNameCapitalized() + ")";
     }
     return result;
 }
 
-OUString toHsCppType (OUString const & name)
+OUString toHsCppType (EntityTable const & entities, OUString const & name)
 {
     if (name.compareTo("hsuno ", 6) == 0)
         return name.copy(6);
@@ -130,12 +171,15 @@ OUString toHsCppType (OUString const & name)
     if (name == "any") return OUString("AnyPtr");
     OUString result;
     if (name == "[]string") {
-        result = "(Ptr (CSequence OUString))";
+        result = "(Ptr (CSequence UString))";
+    } else if (isViewableSequenceType(name)) {
+        result = "(Ptr (CSequence " + toHsSequenceElementType(name.copy(2))
+            + "))";
     } else if (isSequenceType(name)) {
         result = "(Ptr (CSequence ()))";
         //result = "(Ptr (CSequence " + toHsCppType(name.copy(2)) + "))";
     } else {
-        result = "(Ptr " + Module(name).getNameCapitalized() + ")";
+        result = "(Ptr " + entities.getPath(name).getNameCapitalized() + ")";
     }
     return result;
 }
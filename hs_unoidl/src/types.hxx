@@ -12,15 +12,27 @@
 #include <vector>
 #include "rtl/ustring.hxx"
 
+class EntityTable;
+
 bool isHsUnoType (rtl::OUString const & type);
 bool isBasicType (rtl::OUString const & type);
 bool isSimpleType (rtl::OUString const & type);
 bool isPrimitiveType (rtl::OUString const & type);
 bool isStringType (rtl::OUString const & type);
 bool isSequenceType (rtl::OUString const & type);
+// sequences of basic types, which Haskell code views without copying
+bool isViewableSequenceType (rtl::OUString const & type);
+rtl::OUString toHsSequenceElementType (rtl::OUString const & type);
+// size (and alignment) in memory of basic types
+sal_Int32 basicTypeSize (rtl::OUString const & type);
+// Haskell types of basic types as read from memory
+rtl::OUString toHsStorableType (rtl::OUString const & type);
 rtl::OUString toCppType (rtl::OUString const & name);
-rtl::OUString toHsType (rtl::OUString const & name);
-rtl::OUString toHsCppType (rtl::OUString const & name);
+// paths of named types are looked up in the table
+rtl::OUString toHsType (EntityTable const & entities,
+        rtl::OUString const & name);
+rtl::OUString toHsCppType (EntityTable const & entities,
+        rtl::OUString const & name);
 rtl::OUString hsTypeCxxPrefix (rtl::OUString const & type);
 rtl::OUString toFunctionPrefix (rtl::OUString const & name);
 std::vector< rtl::OUString > extractModulesFromName (
@@ -28,8 +28,8 @@
 
 using rtl::OUString;
 
-void writePlainStruct (EntityList const & entities, EntityRef const & entity) {
-    const OUString filePath ("gen/" + Module(entity->type).asPathCapitalized());
+void writePlainStruct (EntityTable const & entities, EntityRef const & entity) {
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
 
     // cxx
     OUString cxxFilePath = filePath + cxxFileExtension;
@@ -51,8 +51,8 @@ void writePlainStruct (EntityList const & entities, EntityRef const & entity) {
     hs.writePlainStructTypeEntity();
 }
 
-void writeInterface (EntityList const & entities, EntityRef const & entity) {
-    const OUString filePath ("gen/" + Module(entity->type).asPathCapitalized());
+void writeInterface (EntityTable const & entities, EntityRef const & entity) {
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
 
     // cxx
     OUString cxxFilePath = filePath + cxxFileExtension;
@@ -76,7 +76,7 @@ void writeInterface (EntityList const & entities, EntityRef const & entity) {
 
 void writeException (EntityRef const & entity)
 {
-    const OUString filePath ("gen/" + Module(entity->type).asPathCapitalized());
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
 
     // cxx
     OUString cxxFilePath = filePath + cxxFileExtension;
@@ -95,10 +95,10 @@ void writeException (EntityRef const & entity)
     hs.writeOpening();
 }
 
-void writeSingleInterfaceBasedService (EntityList const & entities,
+void writeSingleInterfaceBasedService (EntityTable const & entities,
         EntityRef const & entity)
 {
-    const OUString filePath ("gen/" + Module(entity->type).asPathCapitalized());
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
 
     // cxx
     OUString cxxFilePath = filePath + cxxFileExtension;
@@ -120,10 +120,22 @@ void writeSingleInterfaceBasedService (EntityList const & entities,
     hs.writeSingleInterfaceBasedServiceEntity();
 }
 
-void writeInterfaceBasedSingleton (EntityList const & entities,
+void writeAccumulationBasedService (EntityTable const & entities,
         EntityRef const & entity)
 {
-    const OUString filePath ("gen/" + Module(entity->type).asPathCapitalized());
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
+
+    // hs
+    OUString hsFilePath = filePath + hsFileExtension;
+    HsWriter hs (File::getFileUrlFromPath(hsFilePath), entity, entities);
+    hs.writeOpening(hs.accumulationBasedServiceEntityDependencies());
+    hs.writeAccumulationBasedServiceEntity();
+}
+
+void writeInterfaceBasedSingleton (EntityTable const & entities,
+        EntityRef const & entity)
+{
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
 
     // hs
     OUString hsFilePath = filePath + hsFileExtension;
@@ -132,17 +144,26 @@ void writeInterfaceBasedSingleton (EntityList const & entities,
     hs.writeInterfaceBasedSingletonEntity();
 }
 
-void writeModule (ModuleList const & modules, const EntityRef & entity) {
-    const OUString filePath ("gen/" + Module(entity->type).asPathCapitalized());
+void writeConstantGroup (EntityRef const & entity)
+{
+    const OUString filePath ("gen/" + entity->path.asPathCapitalized());
 
-    ModuleList::const_iterator entitiesIt = modules.find(entity->type);
-    assert(entitiesIt != modules.end());
-    EntityList entities = entitiesIt->second;
+    // hs
+    OUString hsFilePath = filePath + hsFileExtension;
+    HsWriter hs (File::getFileUrlFromPath(hsFilePath), entity);
+    hs.writeOpening();
+    hs.writeConstantGroupEntity();
+}
+
+void writeModule (EntityTable const & entities,
+        EntityTable::ModuleEntry const & module)
+{
+    const OUString filePath ("gen/" + module.module->path.asPathCapitalized());
 
     OUString hsFilePath = filePath + hsFileExtension;
-    HsWriter hs (File::getFileUrlFromPath(hsFilePath), entity, entities);
+    HsWriter hs (File::getFileUrlFromPath(hsFilePath), module.module, entities);
     hs.writeOpening();
-    hs.writeModule();
+    hs.writeModule(module.members);
 }
 
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
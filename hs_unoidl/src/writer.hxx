@@ -10,20 +10,27 @@
 #define HSUNOIDL_WRITER_HXX
 
 #include "entity.hxx"
+#include "entitytable.hxx"
 
-void writePlainStruct (EntityList const & entities, EntityRef const & entity);
+void writePlainStruct (EntityTable const & entities, EntityRef const & entity);
 
-void writeInterface (EntityList const & entities, EntityRef const & entity);
+void writeInterface (EntityTable const & entities, EntityRef const & entity);
 
 void writeException (EntityRef const & entity);
 
-void writeSingleInterfaceBasedService (EntityList const & entities,
+void writeSingleInterfaceBasedService (EntityTable const & entities,
         EntityRef const & entity);
 
-void writeInterfaceBasedSingleton (EntityList const & entities,
+void writeAccumulationBasedService (EntityTable const & entities,
         EntityRef const & entity);
 
-void writeModule (ModuleList const & modules, const EntityRef & entity);
+void writeInterfaceBasedSingleton (EntityTable const & entities,
+        EntityRef const & entity);
+
+void writeConstantGroup (EntityRef const & entity);
+
+void writeModule (EntityTable const & entities,
+        EntityTable::ModuleEntry const & module);
 
 #endif /* HSUNOIDL_WRITER_HXX */
 /* vim:set shiftwidth=4 softtabstop=4 expandtab: */
@@ -10,6 +10,7 @@
 
 #include "unoidl/unoidl.hxx"
 
+#include "../options.hxx"
 #include "../types.hxx"
 #include "../utils.hxx"
 
@@ -19,7 +20,9 @@ using std::vector;
 void CxxWriter::writeOpening () {
     out << "#include \"" << capitalize(entity->getName()) << headerFileExtension
         << "\"" << std::endl;
+    out << "#include \"UNO/Accounting.hxx\"" << std::endl;
     out << "#include \"UNO/Binary.hxx\"" << std::endl;
+    out << "#include \"UNO/Text.h\"" << std::endl;
     out << "#include \"rtl/ref.hxx\"" << std::endl;
 }
 
@@ -28,12 +31,16 @@ void CxxWriter::writePlainStructTypeEntity ()
     OUString name (entity->getName());
     OUString entityNameCapitalized (capitalize(name));
     OUString fqn = entity->type;
-    OUString fqnCpp = Module(fqn).asNamespace();
+    OUString fqnCpp = entity->path.asNamespace();
     rtl::Reference< unoidl::PlainStructTypeEntity > ent (
             static_cast< unoidl::PlainStructTypeEntity * >(entity->unoidl.get()));
 
     OUString dataName (capitalize(name));
 
+    // flat structs are read and written in place by Haskell code
+    if (entities.isFlatStruct(entity->type))
+        return;
+
     vector< unoidl::PlainStructTypeEntity::Member > members = ent->getDirectMembers();
     vector< Parameter > getterParams;
     getterParams.push_back({ "hsuno " + fqnCpp + " *", "o" + name }); // FIXME hardcoded type
@@ -42,10 +49,7 @@ void CxxWriter::writePlainStructTypeEntity ()
     for (vector< unoidl::PlainStructTypeEntity::Member >::const_iterator
             j(members.begin()) ; j != members.end() ; ++j)
     {
-        bool isInterface = false;
-        EntityList::const_iterator entIt = entities.find(j->type);
-        if (entIt != entities.end() && entIt->second->isInterface())
-            isInterface = true;
+        bool isInterface = entities.isInterface(j->type);
         // getter
         OUString getterName (functionPrefix + toFunctionPrefix(fqn)
                 + "_get_" + j->name);
@@ -121,7 +125,7 @@ void CxxWriter::writePlainStructTypeEntity ()
 
 void CxxWriter::writeInterfaceTypeEntity () {
     OUString name (entity->getName());
-    Module entityModule (entity->type);
+    Module const & entityModule (entity->path);
     OUString fqn = entityModule.getName();
     OUString fqnCpp = entityModule.asNamespace();
     rtl::Reference<unoidl::InterfaceTypeEntity> ent (
@@ -129,100 +133,206 @@ void CxxWriter::writeInterfaceTypeEntity () {
 
     vector< unoidl::InterfaceTypeEntity::Method > methods = ent->getDirectMethods();
 
+    // resolve the interface members once per process
+    OUString cMembersName (functionPrefix + toFunctionPrefix(fqn) + "_members");
+    if (options.dispatch == DISPATCH_BY_POSITION) {
+        out << std::endl;
+        out << "static HsunoInterfaceMembers const * " << cMembersName << " () {"
+            << std::endl;
+        indent(4);
+        out << "static HsunoInterfaceMembers const * members" << std::endl;
+        indent(8);
+        out << "= hsunoGetInterfaceMembers(\"" << fqn << "\");" << std::endl;
+        indent(4);
+        out << "return members;" << std::endl;
+        out << "}" << std::endl;
+    }
+
+    // direct attributes precede the direct methods in the interface members;
+    // attributes are read with no arguments and written with the value
+    vector< unoidl::InterfaceTypeEntity::Attribute > attributes (
+            ent->getDirectAttributes());
+    sal_Int32 position = 0;
+    for (vector< unoidl::InterfaceTypeEntity::Attribute >::const_iterator
+            a(attributes.begin()) ; a != attributes.end() ; ++a, ++position)
+    {
+        vector< unoidl::InterfaceTypeEntity::Method::Parameter > noParams;
+        unoidl::InterfaceTypeEntity::Method getter (a->name, a->type, noParams,
+                a->getExceptions, vector< OUString >());
+        writeMemberStub(functionPrefix + toFunctionPrefix(fqn) + "_get_"
+                + a->name, position, getter);
+        if (a->readOnly)
+            continue;
+        vector< unoidl::InterfaceTypeEntity::Method::Parameter > params;
+        params.push_back(unoidl::InterfaceTypeEntity::Method::Parameter(
+                    a->name, a->type, unoidl::InterfaceTypeEntity::Method
+                    ::Parameter::DIRECTION_IN));
+        unoidl::InterfaceTypeEntity::Method setter (a->name, "void", params,
+                a->setExceptions, vector< OUString >());
+        writeMemberStub(functionPrefix + toFunctionPrefix(fqn) + "_set_"
+                + a->name, position, setter);
+    }
     for (std::vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
-            j(methods.begin()); j != methods.end(); ++j)
+            j(methods.begin()); j != methods.end(); ++j, ++position)
+    {
+        writeMemberStub(functionPrefix + toFunctionPrefix(fqn) + "_" + j->name,
+                position, *j);
+    }
+}
+
+// Write the stub calling a direct member of the interface, where attributes
+// are given as their getter and setter methods.
+void CxxWriter::writeMemberStub (OUString const & cMethodName,
+        sal_Int32 position, unoidl::InterfaceTypeEntity::Method const & method)
+{
+    OUString fqn = entity->type;
+    OUString cMembersName (functionPrefix + toFunctionPrefix(fqn) + "_members");
+
+    std::vector< Parameter > params;
+    params.push_back({ OUString("hsuno_interface"), OUString("iface") });
+    params.push_back({ OUString("hsuno_exception_ptr"), OUString("exception") });
+    for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
+            k(method.parameters.begin()) ; k != method.parameters.end() ; ++k)
     {
-        OUString cMethodName (functionPrefix + toFunctionPrefix(fqn) + "_"
-                + j->name);
-
-        std::vector< Parameter > params;
-        params.push_back({ OUString("hsuno_interface"), OUString("iface") });
-        params.push_back({ OUString("hsuno_exception_ptr"), OUString("exception") });
-        for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
-                k(j->parameters.begin()) ; k != j->parameters.end() ; ++k)
+        // strings are passed as they are held by Haskell
+        if (isStringType(k->type))
+            params.push_back({ OUString("hsuno rtl_uString *"), k->name });
+        else
             params.push_back({ k->type, k->name });
+    }
 
-        bool isInterface = false;
-        {
-            EntityList::const_iterator entIt = entities.find(j->returnType);
-            if (entIt != entities.end() && entIt->second->isInterface())
-                isInterface = true;
+    bool isInterface = entities.isInterface(method.returnType);
+    // enums and flat structs are returned into memory provided by Haskell
+    bool isStorable = isStorableType(method.returnType);
+    if (isStorable)
+        params.push_back({ method.returnType, OUString("result") });
+    // strings are returned as they are, to be adopted by Haskell
+    OUString cReturnType (isInterface ? OUString("hsuno_interface")
+            : isStringType(method.returnType) ? OUString("hsuno rtl_uString *")
+            : isStorable ? OUString("void")
+            : method.returnType);
+    out << std::endl;
+    out << cFunctionDeclaration(entities, cMethodName, params, cReturnType)
+        << " {" << std::endl;
+    // result type
+    if (method.returnType != "void" && !isStorable) {
+        indent(4);
+        if (isBasicType(method.returnType)) {
+            out << toCppType(method.returnType) << " result;";
+        } else if (isStringType(method.returnType)) {
+            out << "rtl_uString * result = 0;";
+        } else if (method.returnType == "any") {
+            out << "uno_Any * result = hsuno_any_new();";
+        } else if (isSequenceType(method.returnType)) {
+            out << toCppType(method.returnType) << " * result = 0;";
+        } else {
+            // TODO Check non-primitive types for non-interface kinds
+            out << "void * result = 0;";
         }
         out << std::endl;
-        out << cFunctionDeclaration(entities, cMethodName, params,
-                isInterface ? "hsuno_interface" : j->returnType) << " {" << std::endl;
-        // result type
-        if (j->returnType != "void") {
-            indent(4);
-            if (isBasicType(j->returnType)) {
-                out << toCppType(j->returnType) << " result;";
-            } else if (isStringType(j->returnType)) {
-                out << "rtl_uString * result = 0;";
-            } else if (j->returnType == "any") {
-                out << "uno_Any * result = new uno_Any;";
-            } else if (isSequenceType(j->returnType)) {
-                out << toCppType(j->returnType) << " * result = 0;";
-            } else {
-                // TODO Check non-primitive types for non-interface kinds
-                out << "void * result = 0;";
-            }
-            out << std::endl;
-        }
-        // prepare arguments
-        // TODO no need for arguments when there are no parameters
+    }
+    // prepare arguments; calls without parameters (such as attribute
+    // getters) pass no argument array
+    bool hasArguments = !method.parameters.empty();
+    if (hasArguments) {
         indent(4);
-        out << "void * args [" << j->parameters.size() << "];" << std::endl;
-        int argIdx = 0;
-        for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
-                k(j->parameters.begin()) ; k != j->parameters.end() ; ++k)
-        {
-            indent(4);
-            out << "args[" << argIdx << "] = ";
-            if (isBasicType(k->type)) {
-                out << "&" << k->name;
-            } else if (isStringType(k->type)) {
-                out << "const_cast<rtl_uString **>(&" << k->name << "->pData)";
-            } else {
-                EntityList::const_iterator entIt = entities.find(k->type);
-                if (entIt != entities.end() && entIt->second->isInterface())
-                    out << "&";
-                out << k->name;
-            }
-            out << ";" << std::endl;
-            ++argIdx;
-        }
-        // execute the call
+        out << "void * args [" << method.parameters.size() << "];"
+            << std::endl;
+    }
+    int argIdx = 0;
+    for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
+            k(method.parameters.begin()) ; k != method.parameters.end() ; ++k)
+    {
         indent(4);
-        out << "makeBinaryUnoCall(iface, \"" << fqn << "::" << j->name
+        out << "args[" << argIdx << "] = ";
+        if (isBasicType(k->type)) {
+            out << "&" << k->name;
+        } else if (isStringType(k->type)) {
+            out << "&" << k->name;
+        } else {
+            // interfaces and sequences are passed by their pointers
+            if (entities.isInterface(k->type)
+                    || isSequenceType(k->type))
+                out << "&";
+            out << k->name;
+        }
+        out << ";" << std::endl;
+        ++argIdx;
+    }
+    // execute the call
+    indent(4);
+    if (options.dispatch == DISPATCH_BY_POSITION)
+        out << "makeBinaryUnoCallByPosition(iface, " << cMembersName
+            << "(), " << position << ", ";
+    else
+        out << "makeBinaryUnoCall(iface, \"" << fqn << "::" << method.name
             << "\", ";
-        if (j->returnType == "void")
-            out << "NULL";
-        else if (j->returnType == "any")
-            out << "result";
-        else
-            out << "&result";
-        out << ", args, exception);" << std::endl;
-        // create result and return
-        if (j->returnType != "void") {
-            indent(4);
-            if (isBasicType(j->returnType)) {
-                out << "return result;";
-            } else if (isStringType(j->returnType)) {
-                out << "return new rtl::OUString(result, SAL_NO_ACQUIRE);";
-            } else if (j->returnType == "any" || isSequenceType(j->returnType)) {
-                out << "return result;";
+    if (method.returnType == "void")
+        out << "NULL";
+    else if (method.returnType == "any" || isStorable)
+        out << "result";
+    else
+        out << "&result";
+    out << ", " << (hasArguments ? "args" : "NULL") << ", exception);"
+        << std::endl;
+    // count what is handed over to Haskell: the exception, or the result
+    indent(4);
+    out << "if (*exception != 0)" << (method.returnType == "any" ? " {" : "")
+        << std::endl;
+    indent(8);
+    out << "hsunoAccountingCount(HSUNO_COUNT_ANY_CONSTRUCTED);" << std::endl;
+    if (method.returnType == "any") {
+        // the result Any was not constructed, and Haskell does not get it
+        indent(8);
+        out << "hsuno_any_delete(result);" << std::endl;
+        indent(8);
+        out << "result = 0;" << std::endl;
+        indent(4);
+        out << "}" << std::endl;
+    }
+    if (isInterface) {
+        indent(4);
+        out << "else if (result != 0) {" << std::endl;
+        indent(8);
+        out << "static rtl::OUString const sResultType (\""
+            << method.returnType << "\");" << std::endl;
+        indent(8);
+        out << "hsunoAccountingInterfaceAcquired(result, sResultType.pData);"
+            << std::endl;
+        indent(4);
+        out << "}" << std::endl;
+    } else if (isStringType(method.returnType)
+            || method.returnType == "any"
+            || isSequenceType(method.returnType)) {
+        indent(4);
+        out << "else" << std::endl;
+        indent(8);
+        out << "hsunoAccountingCount("
+            << (isStringType(method.returnType) ? "HSUNO_COUNT_USTRING_CREATED"
+                : method.returnType == "any" ? "HSUNO_COUNT_ANY_CONSTRUCTED"
+                : "HSUNO_COUNT_SEQUENCE_ACQUIRED")
+            << ");" << std::endl;
+    }
+    // create result and return
+    if (method.returnType != "void" && !isStorable) {
+        indent(4);
+        if (isBasicType(method.returnType)) {
+            out << "return result;";
+        } else if (isStringType(method.returnType)) {
+            out << "return result;";
+        } else if (method.returnType == "any" || isSequenceType(method.returnType)) {
+            out << "return result;";
+        } else {
+            if (isInterface) {
+                out << "return (uno_Interface *)result;";
             } else {
-                if (isInterface) {
-                    out << "return (uno_Interface *)result;";
-                } else {
-                    OUString ns = Module(j->returnType).asNamespace();
-                    out << "return (" << ns << " *)result;";
-                }
+                OUString ns = entities.getPath(method.returnType).asNamespace();
+                out << "return (" << ns << " *)result;";
             }
-            out << std::endl;
         }
-        out << "}" << std::endl;
+        out << std::endl;
     }
+    out << "}" << std::endl;
 }
 
 void CxxWriter::writeSingleInterfaceBasedServiceEntity () {
@@ -234,9 +344,12 @@ void CxxWriter::writeSingleInterfaceBasedServiceEntity () {
     out << std::endl;
     out << cFunctionDeclaration(entities, cMethodName, params, "hsuno_interface")
         << " {" << std::endl;
-    out << "return hsunoCreateInstanceWithContextFromAscii(\""
-        << entity->type
-        << "\", pContext);" << std::endl;
+    indent(4);
+    out << "static rtl::OUString const sServiceSpecifier (\"" << entity->type
+        << "\");" << std::endl;
+    indent(4);
+    out << "return hsunoCreateInstanceWithContext(sServiceSpecifier.pData,"
+        << " pContext);" << std::endl;
 
     out << "}" << std::endl;
 
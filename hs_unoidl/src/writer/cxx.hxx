@@ -22,11 +22,14 @@ class CxxWriter : public Writer {
         CxxWriter(rtl::OUString const & fileurl, EntityRef const & entity)
             : Writer(fileurl, entity) {};
         CxxWriter(rtl::OUString const & fileurl, EntityRef const & entity,
-                EntityList const & entities)
+                EntityTable const & entities)
             : Writer(fileurl, entity, entities) {};
         void writeOpening ();
         void writePlainStructTypeEntity ();
         void writeInterfaceTypeEntity ();
+        void writeMemberStub (rtl::OUString const & cMethodName,
+                sal_Int32 position,
+                unoidl::InterfaceTypeEntity::Method const & method);
         void writeSingleInterfaceBasedServiceEntity ();
         void writeInterfaceBasedSingletonEntity ();
 };
@@ -10,6 +10,8 @@
 
 #include "unoidl/unoidl.hxx"
 
+#include <algorithm>
+
 #include "../types.hxx"
 #include "../utils.hxx"
 
@@ -19,12 +21,16 @@ using rtl::OUString;
 
 void HsWriter::writeOpening (set< OUString > const & deps) {
     out << "{-# LANGUAGE OverloadedStrings #-} " << std::endl;
-    out << "module " << Module(entity->type).getNameCapitalized()
+    if (hasInterruptibleImports())
+        out << "{-# LANGUAGE InterruptibleFFI #-}" << std::endl;
+    out << "{-# LANGUAGE FlexibleContexts #-}" << std::endl;
+    out << "module " << entity->path.getNameCapitalized()
         << " where" << std::endl;
     out << std::endl;
     out << "import UNO" << std::endl;
     out << std::endl;
     out << "import Control.Applicative ((<$>))" << std::endl;
+    out << "import Control.Exception (finally)" << std::endl;
     out << "import Control.Monad (when)" << std::endl;
     out << "import Data.Int" << std::endl;
     out << "import Data.Text (Text)" << std::endl;
@@ -44,18 +50,20 @@ void HsWriter::writeOpening (set< OUString > const & deps) {
 }
 
 void HsWriter::writeForeignImport (OUString & cfname, OUString & fname,
-        vector< OUString > & params, OUString & rtype)
+        vector< OUString > & params, OUString & rtype, FfiSafety safety)
 {
-    out << "foreign import ccall"
-        << " \"" << cfname << "\" " << fname << std::endl;
+    out << "foreign import ccall";
+    if (safety != FFI_SAFE)
+        out << " " << ffiSafetyKeyword(safety);
+    out << " \"" << cfname << "\" " << fname << std::endl;
     out << "    :: ";
     for (vector< OUString >::const_iterator it (params.begin()) ;
             it != params.end() ; ++it)
     {
-        out << toHsCppType(*it) << " -> ";
+        out << toHsCppType(entities, *it) << " -> ";
     }
     out << "IO ";
-    out << toHsCppType(rtype) << std::endl;
+    out << toHsCppType(entities, rtype) << std::endl;
 }
 
 void HsWriter::writeFunctionType (OUString & fname,
@@ -76,10 +84,10 @@ void HsWriter::writeFunctionType (OUString & fname,
     }
     for (vector< Parameter >::const_iterator it (params.begin())
             ; it != params.end() ; ++it)
-        out << toHsType(it->type) << " -> ";
+        out << toHsType(entities, it->type) << " -> ";
     if (io)
         out << "IO ";
-    out << toHsType(rtype);
+    out << toHsType(entities, rtype);
 }
 
 void HsWriter::writeFunctionLHS (OUString & fname, vector< Parameter > & params)
@@ -91,6 +99,39 @@ void HsWriter::writeFunctionLHS (OUString & fname, vector< Parameter > & params)
     out << " =";
 }
 
+void HsWriter::writeAsyncFunction (OUString & fname, OUString & syncfname,
+        vector< OUString > & classes, vector< Parameter > & params,
+        OUString & rtype)
+{
+    out << std::endl;
+    out << fname << " :: ";
+    if (classes.size() > 0) {
+        out << "(";
+        for (vector< OUString >::const_iterator it (classes.begin()) ;
+                it != classes.end() ; ++it)
+        {
+            if (it != classes.begin())
+                out << ", ";
+            out << *it;
+        }
+        out << ") => ";
+    }
+    out << "Executor -> ";
+    for (vector< Parameter >::const_iterator it (params.begin())
+            ; it != params.end() ; ++it)
+        out << toHsType(entities, it->type) << " -> ";
+    out << "IO (Future " << toHsType(entities, rtype) << ")" << std::endl;
+    out << fname << " executor";
+    for (vector< Parameter >::const_iterator it (params.begin())
+            ; it != params.end() ; ++it)
+        out << " " << it->name;
+    out << " = submit executor $ " << syncfname;
+    for (vector< Parameter >::const_iterator it (params.begin())
+            ; it != params.end() ; ++it)
+        out << " " << it->name;
+    out << std::endl;
+}
+
 void HsWriter::writePlainStructTypeEntity ()
 {
     OUString entityName (entity->getName());
@@ -99,6 +140,10 @@ void HsWriter::writePlainStructTypeEntity ()
     rtl::Reference< unoidl::PlainStructTypeEntity > ent (
             static_cast< unoidl::PlainStructTypeEntity * >(entity->unoidl.get()));
 
+    // flat structs are records of their module
+    if (entities.isFlatStruct(entity->type))
+        return;
+
     OUString dataName (entityNameCapitalized);
     out << "data " << dataName << std::endl;
 
@@ -117,7 +162,8 @@ void HsWriter::writePlainStructTypeEntity ()
 
         OUString getterType (j->type);
         out << std::endl;
-        writeForeignImport(cGetterName, hsGetterName, getterParams, getterType);
+        writeForeignImport(cGetterName, hsGetterName, getterParams, getterType,
+                FFI_UNSAFE);
 
         // setter
         OUString cSetterName (functionPrefix + toFunctionPrefix(fqn)
@@ -130,178 +176,345 @@ void HsWriter::writePlainStructTypeEntity ()
         setterParams.push_back(j->type);
 
         out << std::endl;
-        writeForeignImport(cSetterName, hsSetterName, setterParams, setterType);
+        writeForeignImport(cSetterName, hsSetterName, setterParams, setterType,
+                FFI_UNSAFE);
     }
 
     // constructor
     // TODO
 }
 
-void HsWriter::writeInterfaceTypeEntity () {
-    rtl::Reference<unoidl::InterfaceTypeEntity> ent (
-            static_cast<unoidl::InterfaceTypeEntity *>(entity->unoidl.get()));
-    OUString entityName (entity->getName());
-    OUString entityNameCapitalized (capitalize(entityName));
-    OUString fqn = entity->type;
-    vector< unoidl::InterfaceTypeEntity::Method > members = ent->getDirectMethods();
+OUString HsWriter::sequenceArgumentElementType (OUString const & type)
+{
+    if (!isSequenceType(type))
+        return OUString();
+    OUString elementType (type.copy(2));
+    if (isViewableSequenceType(type))
+        return toHsSequenceElementType(elementType);
+    if (isStringType(elementType))
+        return OUString("UString");
+    if (entities.isInterface(elementType))
+        return entities.getPath(elementType).getNameCapitalized();
+    return OUString();
+}
 
-    for (vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
-            m(members.begin()) ; m != members.end() ; ++m)
+void HsWriter::methodParameters (
+        unoidl::InterfaceTypeEntity::Method const & method,
+        vector< Parameter > & methodParams, vector< OUString > & classes)
+{
+    methodParams.push_back({ entity->type, OUString("rIface") });
+    for (vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
+            p(method.parameters.begin()) ; p != method.parameters.end() ; ++p)
     {
-        OUString hsMethodName (m->name);
-        OUString hsForeignMethodName ("c" + entityNameCapitalized + "_" + m->name);
-        vector< OUString > classes;
-        vector< Parameter > methodParams;
-        vector< Parameter > params;
-        OUString type (m->returnType);
-
-        unsigned int level = 0;
-
-        methodParams.push_back({ fqn, OUString("rIface") });
-        for (vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
-                p(m->parameters.begin()) ; p != m->parameters.end() ; ++p) {
-            OUString paramName (decapitalize(p->name));
+        OUString paramName (decapitalize(p->name));
+        OUString elementType (sequenceArgumentElementType(p->type));
+        if (isStorableType(p->type)) {
+            methodParams.push_back({ "hsuno "
+                    + entities.getPath(p->type).getNameCapitalized(),
+                    paramName });
+        } else if (elementType.isEmpty()) {
             methodParams.push_back({ p->type, paramName });
-            params.push_back({ p->type, paramName });
+        } else {
+            // sequences are taken from anything convertible to them
+            OUString var ("s" + OUString::number(classes.size()));
+            classes.push_back("ToSequence " + var + " " + elementType);
+            methodParams.push_back({ "hsuno " + var, paramName });
         }
+    }
+}
 
-        out << std::endl;
-        indent(level);
-        writeFunctionType(hsMethodName, classes, methodParams, type);
-        out << std::endl;
-        indent(level);
-        writeFunctionLHS(hsMethodName, methodParams);
-        out << " do" << std::endl;
-        level += 2;
-        // prepare arguments
-        std::vector< OUString > arguments;
-        for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
-                k(m->parameters.begin());
-                k != m->parameters.end(); ++k)
-        {
-            OUString argType (k->type);
-            OUString name (decapitalize(k->name));
-            if (isStringType(k->type)) {
-                OUString s (hsTypeCxxPrefix(k->type) + name);
+OUString HsWriter::methodResultType (OUString const & type, bool lazyResult)
+{
+    // lazy results are handed over undecoded
+    if (lazyResult && type == "any")
+        return OUString("hsuno AnyView");
+    if (lazyResult && isStringType(type))
+        return OUString("hsuno UStringRef");
+    // enums and flat structs are returned as their Storable values
+    if (isStorableType(type))
+        return "hsuno " + entities.getPath(type).getNameCapitalized();
+    return type;
+}
+
+void HsWriter::writeMethod (OUString & hsMethodName,
+        OUString & hsForeignMethodName,
+        unoidl::InterfaceTypeEntity::Method const & method, bool lazyResult)
+{
+    vector< OUString > classes;
+    vector< Parameter > methodParams;
+    OUString type (method.returnType);
+    OUString hsType (methodResultType(type, lazyResult));
+
+    unsigned int level = 0;
+
+    methodParameters(method, methodParams, classes);
+
+    out << std::endl;
+    indent(level);
+    writeFunctionType(hsMethodName, classes, methodParams, hsType);
+    out << std::endl;
+    indent(level);
+    writeFunctionLHS(hsMethodName, methodParams);
+    out << " do" << std::endl;
+    level += 2;
+    // prepare arguments
+    std::vector< OUString > arguments;
+    for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
+            k(method.parameters.begin());
+            k != method.parameters.end(); ++k)
+    {
+        OUString argType (k->type);
+        OUString name (decapitalize(k->name));
+        if (isStringType(k->type)) {
+            // interned strings are passed as they are, others are released
+            // after the call
+            OUString s (hsTypeCxxPrefix(k->type) + name);
+            arguments.push_back(s);
+            indent(level);
+            out << "withUStringArg " << name << " $ \\ " << s << " -> do "
+                << std::endl;
+            level += 2;
+        } else if (argType == "any") {
+            OUString s ("p" + name);
+            arguments.push_back(s);
+            indent(level);
+            out << "withAny " << name << " $ \\ " << s << " -> do "
+                << std::endl;
+            level += 2;
+        } else {
+            bool argIsInterface = entities.isInterface(argType);
+            if (isStorableType(argType)) {
+                OUString s ("p" + name);
                 arguments.push_back(s);
                 indent(level);
-                out << s << " <- hs_text_to_oustring " << name << std::endl;
-                // FIXME Check if the OUString is destructed.
-                // If not, create a function "withOUStringText" that handles that.
-            } else if (argType == "any") {
+                out << "with " << name << " $ \\ " << s << " -> do "
+                    << std::endl;
+                level += 2;
+            } else if (!sequenceArgumentElementType(argType).isEmpty()) {
+                OUString s ("p" + name);
+                arguments.push_back("(castPtr " + s + ")");
+                indent(level);
+                out << "withSequence " << name << " $ \\ " << s
+                    << " -> do " << std::endl;
+                level += 2;
+            } else if (argIsInterface) {
                 OUString s ("p" + name);
                 arguments.push_back(s);
                 indent(level);
-                out << "withAny " << name << " $ \\ " << s << " -> do "
+                out << "withReference " << name << " $ \\ " << s
+                    << " -> do " << std::endl;
+                level += 2;
+            } else if (!isPrimitiveType(k->type) && !isSequenceType(k->type)) {
+                OUString s ("p" + name);
+                arguments.push_back(s);
+                indent(level);
+                out << "withForeignPtr " << name << " $ \\ " << s << " -> do "
                     << std::endl;
                 level += 2;
             } else {
-                bool argIsInterface = false;
-                {
-                    EntityList::const_iterator entIt = entities.find(argType);
-                    if (entIt != entities.end() && entIt->second->isInterface())
-                        argIsInterface = true;
-                }
-                if (argIsInterface) {
-                    OUString s ("p" + name);
-                    arguments.push_back(s);
-                    indent(level);
-                    out << "withReference " << name << " $ \\ " << s
-                        << " -> do " << std::endl;
-                    level += 2;
-                } else if (!isPrimitiveType(k->type) && !isSequenceType(k->type)) {
-                    OUString s ("p" + name);
-                    arguments.push_back(s);
-                    indent(level);
-                    out << "withForeignPtr " << name << " $ \\ " << s << " -> do "
-                        << std::endl;
-                    level += 2;
-                } else {
-                    arguments.push_back(name);
-                }
+                arguments.push_back(name);
             }
         }
-        // get interface pointer
-        indent(level);
-        out << "withReference rIface $ \\ pIface -> do" << std::endl;
-        level += 2;
-        // prepare exception pointer
+    }
+    // enums and flat structs are returned into memory allocated here
+    if (isStorableType(type)) {
+        arguments.push_back("pResult");
         indent(level);
-        out << "with nullPtr $ \\ exceptionPtr -> do" << std::endl;
+        out << "alloca $ \\ pResult -> do" << std::endl;
         level += 2;
-        // run method
-        indent(level);
-        out << "result <- " << hsForeignMethodName << " pIface exceptionPtr";
-        for (std::vector< OUString >::const_iterator
-                k(arguments.begin()); k != arguments.end(); ++k)
-        {
-            out << " " << *k;
-        }
-        out << std::endl;
-        // check for exceptions
-        indent(level);
-        out << "aException <- peek exceptionPtr" << std::endl;
-        indent(level);
-        out << "when (aException /= nullPtr) (error \"exceptions not yet implemented\")"
-            << std::endl;
-        bool isInterface = false;
-        {
-            EntityList::const_iterator entIt = entities.find(m->returnType);
-            if (entIt != entities.end() && entIt->second->isInterface())
-                isInterface = true;
+    }
+    // get interface pointer
+    indent(level);
+    out << "withReference rIface $ \\ pIface -> do" << std::endl;
+    level += 2;
+    // prepare exception pointer, to the storage of the exception
+    indent(level);
+    out << "allocaBytes anyStructSize $ \\ pException -> do" << std::endl;
+    level += 2;
+    indent(level);
+    out << "with pException $ \\ exceptionPtr -> do" << std::endl;
+    level += 2;
+    // run method
+    indent(level);
+    out << "result <- " << hsForeignMethodName << " pIface exceptionPtr";
+    for (std::vector< OUString >::const_iterator
+            k(arguments.begin()); k != arguments.end(); ++k)
+    {
+        out << " " << *k;
+    }
+    out << std::endl;
+    // check for exceptions
+    indent(level);
+    out << "throwIfUnoException =<< peek exceptionPtr" << std::endl;
+    bool isInterface = entities.isInterface(method.returnType);
+    // return
+    indent(level);
+    if (type == "void") {
+        out << "return ()" << std::endl;
+    } else if (type == "any") {
+        if (lazyResult) {
+            out << "anyViewFromUno (castPtr result)" << std::endl;
+        } else {
+            out << "anyFromUno (castPtr result) `finally` anyFree (castPtr result)"
+                << std::endl;
         }
-        // return
-        indent(level);
-        if (type == "void") {
-            out << "return ()" << std::endl;
-        } else if (type == "any") {
-            out << "anyFromUno (castPtr result)" << std::endl;
-        } else if (isBasicType(m->returnType)) {
-            out << "return result" << std::endl;
-        } else if (isInterface) {
-            out << "mkReference result" << std::endl;
+    } else if (isBasicType(method.returnType)) {
+        out << "return result" << std::endl;
+    } else if (isInterface) {
+        out << "mkReference result" << std::endl;
+    } else if (isStorableType(type)) {
+        out << "peek pResult" << std::endl;
+    } else {
+        OUString methodResult;
+        methodResult = "methodResult";
+        if (method.returnType == "string" && lazyResult) {
+            out << "methodResult <- adoptUString result" << std::endl;
+            indent(level);
+        } else if (method.returnType == "string") {
+            out << "methodResult <- uStringToText result" << std::endl;
+            indent(level);
+            out << "uStringRelease result" << std::endl;
+            indent(level);
+        } else if (method.returnType == "[]string") {
+            out << "methodResult <- textsFromSequence result" << std::endl;
+            indent(level);
+            out << "sequenceRelease result" << std::endl;
+            indent(level);
+        } else if (isViewableSequenceType(method.returnType)) {
+            out << "methodResult <- adoptSequence result" << std::endl;
+            indent(level);
+        } else if (isSequenceType(method.returnType)) { // FIXME
+            methodResult = "result";
         } else {
-            OUString methodResult;
-            methodResult = "methodResult";
-            if (m->returnType == "string") {
-                out << "methodResult <- hs_oustring_to_text result" << std::endl;
-                indent(level);
-                out << "c_delete_oustring result" << std::endl;
-                indent(level);
-            } else if (m->returnType == "[]string") { // FIXME
-                out << "fpResult <- FC.newForeignPtr result (sequenceRelease result)"
-                    << std::endl;
-                indent(level);
-                out << "methodResult <- fromSequence fpResult" << std::endl;
-                indent(level);
-            } else if (isSequenceType(m->returnType)) { // FIXME
-                methodResult = "result";
-            } else {
-                methodResult = "result";
-            }
-            out << "return " << methodResult << std::endl;
+            methodResult = "result";
         }
+        out << "return " << methodResult << std::endl;
     }
+}
+
+void HsWriter::writeInterfaceTypeEntity () {
+    rtl::Reference<unoidl::InterfaceTypeEntity> ent (
+            static_cast<unoidl::InterfaceTypeEntity *>(entity->unoidl.get()));
+    OUString entityName (entity->getName());
+    OUString entityNameCapitalized (capitalize(entityName));
+    vector< unoidl::InterfaceTypeEntity::Method > members = ent->getDirectMethods();
+    set< OUString > methodNames;
+    for (vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+        methodNames.insert(m->name);
 
-    // foreign imports
     for (vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
             m(members.begin()) ; m != members.end() ; ++m)
     {
-        OUString cMethodName (functionPrefix + toFunctionPrefix(fqn) + "_"
-                + m->name);
-        OUString hsMethodName ("c" + entityNameCapitalized + "_" + m->name);
-        vector< OUString > params;
+        OUString hsMethodName (m->name);
+        OUString hsForeignMethodName ("c" + entityNameCapitalized + "_" + m->name);
         OUString type (m->returnType);
+        vector< OUString > classes;
+        vector< Parameter > methodParams;
+        methodParameters(*m, methodParams, classes);
 
-        params.push_back(fqn);
-        params.push_back("hsuno_exception_ptr");
-        for (vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
-                p(m->parameters.begin()) ; p != m->parameters.end() ; ++p)
-            params.push_back(p->type);
+        writeMethod(hsMethodName, hsForeignMethodName, *m);
 
-        out << std::endl;
-        writeForeignImport(cMethodName, hsMethodName, params, type);
+        // lazy variant, returning the result without decoding it
+        if (type == "any" || isStringType(type)) {
+            OUString hsLazyMethodName (hsMethodName + "'");
+            writeMethod(hsLazyMethodName, hsForeignMethodName, *m, true);
+        }
+
+        // asynchronous variant, unless it would clash with another method
+        OUString hsAsyncMethodName (hsMethodName + "Async");
+        OUString hsType (methodResultType(type));
+        if (methodNames.count(hsAsyncMethodName) == 0)
+            writeAsyncFunction(hsAsyncMethodName, hsMethodName, classes,
+                    methodParams, hsType);
+    }
+
+    // attributes, unless their accessors would clash with a method
+    vector< unoidl::InterfaceTypeEntity::Attribute > attributes (
+            ent->getDirectAttributes());
+    for (vector<unoidl::InterfaceTypeEntity::Attribute>::const_iterator
+            a(attributes.begin()) ; a != attributes.end() ; ++a)
+    {
+        OUString getterName ("get" + capitalize(a->name));
+        if (methodNames.count(getterName) == 0) {
+            OUString hsForeignName ("c" + entityNameCapitalized + "_get_"
+                    + a->name);
+            writeMethod(getterName, hsForeignName, attributeGetter(*a));
+        }
+        OUString setterName ("set" + capitalize(a->name));
+        if (!a->readOnly && methodNames.count(setterName) == 0) {
+            OUString hsForeignName ("c" + entityNameCapitalized + "_set_"
+                    + a->name);
+            writeMethod(setterName, hsForeignName, attributeSetter(*a));
+        }
     }
+
+    // foreign imports
+    for (vector<unoidl::InterfaceTypeEntity::Attribute>::const_iterator
+            a(attributes.begin()) ; a != attributes.end() ; ++a)
+    {
+        if (methodNames.count("get" + capitalize(a->name)) == 0)
+            writeMemberForeignImport("_get_" + a->name, attributeGetter(*a));
+        if (!a->readOnly && methodNames.count("set" + capitalize(a->name)) == 0)
+            writeMemberForeignImport("_set_" + a->name, attributeSetter(*a));
+    }
+    for (vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+        writeMemberForeignImport("_" + m->name, *m);
+}
+
+// Write the foreign import of the stub of a direct member, named by its
+// suffix.
+void HsWriter::writeMemberForeignImport (OUString const & suffix,
+        unoidl::InterfaceTypeEntity::Method const & method)
+{
+    OUString fqn = entity->type;
+    OUString cMethodName (functionPrefix + toFunctionPrefix(fqn) + suffix);
+    OUString hsMethodName ("c" + capitalize(entity->getName()) + suffix);
+    vector< OUString > params;
+    OUString type (method.returnType);
+
+    params.push_back(fqn);
+    params.push_back("hsuno_exception_ptr");
+    for (vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
+            p(method.parameters.begin()) ; p != method.parameters.end() ; ++p)
+    {
+        if (isStringType(p->type))
+            params.push_back("hsuno (Ptr UString)");
+        else
+            params.push_back(p->type);
+    }
+    if (isStringType(type))
+        type = "hsuno (Ptr UString)";
+    if (isStorableType(type)) {
+        params.push_back(type);
+        type = "void";
+    }
+
+    out << std::endl;
+    writeForeignImport(cMethodName, hsMethodName, params, type,
+            ffiSafety(fqn, method.name));
+}
+
+// Attributes are read by a method without parameters and written by a method
+// taking the value, as binary UNO dispatches them.
+unoidl::InterfaceTypeEntity::Method HsWriter::attributeGetter (
+        unoidl::InterfaceTypeEntity::Attribute const & attribute)
+{
+    return unoidl::InterfaceTypeEntity::Method(attribute.name, attribute.type,
+            vector< unoidl::InterfaceTypeEntity::Method::Parameter >(),
+            attribute.getExceptions, vector< OUString >());
+}
+
+unoidl::InterfaceTypeEntity::Method HsWriter::attributeSetter (
+        unoidl::InterfaceTypeEntity::Attribute const & attribute)
+{
+    vector< unoidl::InterfaceTypeEntity::Method::Parameter > params;
+    params.push_back(unoidl::InterfaceTypeEntity::Method::Parameter(
+                "value", attribute.type, unoidl::InterfaceTypeEntity::Method
+                ::Parameter::DIRECTION_IN));
+    return unoidl::InterfaceTypeEntity::Method(attribute.name, "void", params,
+            attribute.setExceptions, vector< OUString >());
 }
 
 void HsWriter::writeExceptionTypeEntity () {
@@ -314,11 +527,11 @@ void HsWriter::writeSingleInterfaceBasedServiceEntity () {
     OUString entityNameCapitalized (capitalize(entityName));
     OUString entityFullName (entity->type);
     // entity module (including its name)
-    Module eModule = Module(entity->type);
+    Module const & eModule (entity->path);
     // entity fully qualified name
     OUString eFQN (eModule.asNamespace());
     // entity base module
-    Module eBaseModule(ent->getBase());
+    Module const & eBaseModule (entities.getPath(ent->getBase()));
     OUString sEntityBase (ent->getBase());
     OUString sEntityBaseLastNameCapitalized
         (capitalize(eBaseModule.getLastName()));
@@ -359,6 +572,55 @@ void HsWriter::writeSingleInterfaceBasedServiceEntity () {
     }
 }
 
+void HsWriter::writeAccumulationBasedServiceEntity () {
+    rtl::Reference<unoidl::AccumulationBasedServiceEntity> ent (
+            static_cast<unoidl::AccumulationBasedServiceEntity *>(entity->unoidl.get()));
+    OUString prefix (decapitalize(entity->getName()));
+
+    // property access
+    out << std::endl;
+    out << "-- |Property access to a " << entity->type << "." << std::endl;
+    out << prefix << "Properties :: Reference a -> IO PropertyAccess"
+        << std::endl;
+    out << prefix << "Properties = propertyAccess" << std::endl;
+
+    // typed accessors of the direct properties
+    vector< unoidl::AccumulationBasedServiceEntity::Property > properties (
+            ent->getDirectProperties());
+    for (vector<unoidl::AccumulationBasedServiceEntity::Property>::const_iterator
+            p(properties.begin()) ; p != properties.end() ; ++p)
+    {
+        OUString hsType (propertyType(p->type));
+        if (hsType.isEmpty()) // TODO structs and sequences
+            continue;
+        if (p->attributes & unoidl::AccumulationBasedServiceEntity::Property
+                ::ATTRIBUTE_MAYBE_VOID)
+            hsType = "(Maybe " + hsType + ")";
+        OUString name (capitalize(p->name));
+        // the name is interned once, by a top-level constant
+        OUString hsNameConstant (prefix + "PropertyName" + name);
+        OUString hsName ("(uStringConstantPtr " + hsNameConstant + ")");
+
+        out << std::endl;
+        out << "{-# NOINLINE " << hsNameConstant << " #-}" << std::endl;
+        out << hsNameConstant << " :: UStringConstant" << std::endl;
+        out << hsNameConstant << " = \"" << p->name << "\"" << std::endl;
+        out << std::endl;
+        out << prefix << "Get" << name << " :: PropertyAccess -> IO " << hsType
+            << std::endl;
+        out << prefix << "Get" << name << " p = getPropertyUString p " << hsName
+            << std::endl;
+        if (p->attributes & unoidl::AccumulationBasedServiceEntity::Property
+                ::ATTRIBUTE_READ_ONLY)
+            continue;
+        out << std::endl;
+        out << prefix << "Set" << name << " :: PropertyAccess -> " << hsType
+            << " -> IO ()" << std::endl;
+        out << prefix << "Set" << name << " p = setPropertyUString p " << hsName
+            << std::endl;
+    }
+}
+
 void HsWriter::writeInterfaceBasedSingletonEntity () {
     rtl::Reference<unoidl::InterfaceBasedSingletonEntity> ent (
             static_cast<unoidl::InterfaceBasedSingletonEntity *>(entity->unoidl.get()));
@@ -380,28 +642,347 @@ void HsWriter::writeInterfaceBasedSingletonEntity () {
         << std::endl;
 }
 
-void HsWriter::writeModule () {
+void HsWriter::writeModule (vector< sal_Int32 > const & members) {
     assert(hasEntityList);
 
-    for (EntityList::const_iterator it (entities.begin()) ;
-            it != entities.end() ; ++it)
+    for (vector< sal_Int32 >::const_iterator it (members.begin()) ;
+            it != members.end() ; ++it)
     {
-        OUString name (capitalize(it->second->getName()));
+        EntityRef const & member (entities[*it]);
+        OUString name (capitalize(member->getName()));
         out << std::endl;
+        if (entities.isFlatStruct(*it)) {
+            writeFlatStruct(member);
+            continue;
+        }
+        if (entities.isEnum(*it)) {
+            writeEnum(member);
+            continue;
+        }
+        if (member->unoidl->getSort() == unoidl::Entity::SORT_TYPEDEF) {
+            rtl::Reference< unoidl::TypedefEntity > ent (
+                    static_cast< unoidl::TypedefEntity * >(
+                        member->unoidl.get()));
+            // TODO typedefs of types from other modules
+            if (isSimpleType(ent->getType())) {
+                out << "type " << name << " = " << toHsType(entities, ent->getType())
+                    << std::endl;
+                continue;
+            }
+        }
         out << "data " << name << std::endl;
-        if (it->second->isInterface()) {
+        if (entities.isInterface(*it)) {
             out << "instance IsUnoType " << name << " where"
                 << std::endl;
             indent(4);
             out << "getUnoTypeClass _ = Typelib_TypeClass_INTERFACE"
                 << std::endl;
             indent(4);
-            out << "getUnoTypeName _ = \"" << it->second->type << "\""
+            out << "getUnoTypeName _ = \"" << member->type << "\""
                 << std::endl;
         }
     }
 }
 
+void HsWriter::writeFlatStruct (EntityRef const & flat) {
+    rtl::Reference< unoidl::PlainStructTypeEntity > ent (
+            static_cast< unoidl::PlainStructTypeEntity * >(flat->unoidl.get()));
+    vector< unoidl::PlainStructTypeEntity::Member > members (
+            ent->getDirectMembers());
+    OUString name (capitalize(flat->getName()));
+    OUString prefix (decapitalize(flat->getName()));
+
+    // members are laid out with their natural alignment, which the layout
+    // check confirms against the type description at run time
+    vector< sal_Int32 > offsets;
+    sal_Int32 size = 0;
+    sal_Int32 align = 1;
+    for (vector< unoidl::PlainStructTypeEntity::Member >::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+    {
+        sal_Int32 n = basicTypeSize(m->type);
+        size = (size + n - 1) / n * n;
+        offsets.push_back(size);
+        size += n;
+        if (n > align)
+            align = n;
+    }
+    size = (size + align - 1) / align * align;
+
+    // record
+    out << "data " << name << " = " << name << std::endl;
+    for (vector< unoidl::PlainStructTypeEntity::Member >::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+    {
+        indent(2);
+        out << (m == members.begin() ? "{ " : ", ") << prefix
+            << capitalize(m->name) << " :: "
+            << (m->type == "boolean" ? "!" : "{-# UNPACK #-} !")
+            << toHsStorableType(m->type) << std::endl;
+    }
+    indent(2);
+    out << "} deriving (Eq, Show)" << std::endl;
+
+    out << std::endl;
+    out << "instance IsUnoType " << name << " where" << std::endl;
+    indent(4);
+    out << "getUnoTypeClass _ = Typelib_TypeClass_STRUCT" << std::endl;
+    indent(4);
+    out << "getUnoTypeName _ = \"" << flat->type << "\"" << std::endl;
+
+    // layout check, made once on the first peek or poke
+    OUString layoutName (prefix + "Layout");
+    out << std::endl;
+    out << "{-# NOINLINE " << layoutName << " #-}" << std::endl;
+    out << layoutName << " :: ()" << std::endl;
+    out << layoutName << " = structLayoutChecked \"" << flat->type << "\" "
+        << size << " [";
+    for (vector< sal_Int32 >::const_iterator it (offsets.begin()) ;
+            it != offsets.end() ; ++it)
+        out << (it == offsets.begin() ? "" : ", ") << *it;
+    out << "]" << std::endl;
+
+    // storable instance, reading and writing the whole struct at once
+    out << std::endl;
+    out << "instance Storable " << name << " where" << std::endl;
+    indent(4);
+    out << "sizeOf _ = " << size << std::endl;
+    indent(4);
+    out << "alignment _ = " << align << std::endl;
+    indent(4);
+    out << "peek p = " << layoutName << " `seq` do" << std::endl;
+    for (sal_Int32 i = 0 ; i < sal_Int32(members.size()) ; ++i) {
+        indent(8);
+        out << "m" << i << " <- ";
+        if (members[i].type == "boolean")
+            out << "(/= (0 :: Word8)) <$> ";
+        out << "peekByteOff p " << offsets[i] << std::endl;
+    }
+    indent(8);
+    out << "return (" << name;
+    for (sal_Int32 i = 0 ; i < sal_Int32(members.size()) ; ++i)
+        out << " m" << i;
+    out << ")" << std::endl;
+    indent(4);
+    out << "poke p v = " << layoutName << " `seq` do" << std::endl;
+    for (sal_Int32 i = 0 ; i < sal_Int32(members.size()) ; ++i) {
+        OUString field ("(" + prefix + capitalize(members[i].name) + " v)");
+        indent(8);
+        out << "pokeByteOff p " << offsets[i] << " ";
+        if (members[i].type == "boolean")
+            out << "(fromIntegral (fromEnum " << field << ") :: Word8)";
+        else
+            out << field;
+        out << std::endl;
+    }
+}
+
+void HsWriter::writeEnum (EntityRef const & e) {
+    rtl::Reference< unoidl::EnumTypeEntity > ent (
+            static_cast< unoidl::EnumTypeEntity * >(e->unoidl.get()));
+    vector< unoidl::EnumTypeEntity::Member > members (ent->getMembers());
+    OUString name (capitalize(e->getName()));
+
+    // sum type, with the UNO values of the constructors given by Enum
+    out << "data " << name << std::endl;
+    for (vector< unoidl::EnumTypeEntity::Member >::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+    {
+        indent(2);
+        out << (m == members.begin() ? "= " : "| ") << name << "_" << m->name
+            << std::endl;
+    }
+    indent(2);
+    out << "deriving (Eq, Ord, Show, Bounded)" << std::endl;
+
+    out << std::endl;
+    out << "instance Enum " << name << " where" << std::endl;
+    for (vector< unoidl::EnumTypeEntity::Member >::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+    {
+        indent(4);
+        out << "fromEnum " << name << "_" << m->name << " = " << m->value
+            << std::endl;
+    }
+    for (vector< unoidl::EnumTypeEntity::Member >::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+    {
+        indent(4);
+        out << "toEnum ";
+        if (m->value < 0)
+            out << "(" << m->value << ")";
+        else
+            out << m->value;
+        out << " = " << name << "_" << m->name << std::endl;
+    }
+    indent(4);
+    out << "toEnum n = error (\"invalid " << e->type << " value \" ++ show n)"
+        << std::endl;
+
+    // ranges stop at the last constructor instead of running into values
+    // that toEnum rejects; values are contiguous in declaration order for
+    // most enums, which the default enumFromTo and enumFromThenTo then cover
+    bool ascending = true;
+    bool contiguous = true;
+    vector< unoidl::EnumTypeEntity::Member > sorted (members);
+    for (vector< unoidl::EnumTypeEntity::Member >::size_type i = 1 ;
+            i < members.size() ; ++i)
+    {
+        if (members[i].value <= members[i - 1].value)
+            ascending = false;
+        if (members[i].value != members[i - 1].value + 1)
+            contiguous = false;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+            [] (unoidl::EnumTypeEntity::Member const & a,
+                unoidl::EnumTypeEntity::Member const & b)
+            { return a.value < b.value; });
+    // maxBound and minBound are the last and first constructors declared
+    OUString high (ascending ? OUString("maxBound")
+            : name + "_" + sorted.back().name);
+    OUString low (ascending ? OUString("minBound")
+            : name + "_" + sorted.front().name);
+    indent(4);
+    out << "enumFrom x = enumFromTo x " << high << std::endl;
+    indent(4);
+    out << "enumFromThen x y = enumFromThenTo x y" << std::endl;
+    indent(6);
+    out << "(if fromEnum y >= fromEnum x then " << high << " else " << low
+        << ")" << std::endl;
+    if (!ascending || !contiguous) {
+        // skip the values between the constructors
+        OUString all ("[");
+        for (vector< unoidl::EnumTypeEntity::Member >::const_iterator
+                m(sorted.begin()) ; m != sorted.end() ; ++m)
+        {
+            if (m != sorted.begin())
+                all += ", ";
+            all += name + "_" + m->name;
+        }
+        all += "]";
+        indent(4);
+        out << "enumFromTo x y = filter" << std::endl;
+        indent(6);
+        out << "(\\ c -> fromEnum c >= fromEnum x && fromEnum c <= fromEnum y)"
+            << std::endl;
+        indent(6);
+        out << all << std::endl;
+        indent(4);
+        out << "enumFromThenTo x y z =" << std::endl;
+        indent(6);
+        out << "[ c | n <- [fromEnum x, fromEnum y .. fromEnum z]" << std::endl;
+        indent(6);
+        out << ", c <- filter ((== n) . fromEnum) " << all << " ]" << std::endl;
+    }
+
+    // the type description, looked up once for all Anys of the enum
+    OUString typeName (decapitalize(e->getName()) + "Type");
+    out << std::endl;
+    out << "{-# NOINLINE " << typeName << " #-}" << std::endl;
+    out << typeName << " :: TypeDescriptionPtr" << std::endl;
+    out << typeName << " = typeDescriptionConstant \"" << e->type << "\""
+        << std::endl;
+
+    out << std::endl;
+    out << "instance IsUnoType " << name << " where" << std::endl;
+    indent(4);
+    out << "getUnoTypeClass _ = Typelib_TypeClass_ENUM" << std::endl;
+    indent(4);
+    out << "getUnoTypeName _ = \"" << e->type << "\"" << std::endl;
+    indent(4);
+    out << "getUnoType _ = return " << typeName << std::endl;
+
+    // enums are held as 32-bit integers, in memory and in Anys
+    out << std::endl;
+    out << "instance Storable " << name << " where" << std::endl;
+    indent(4);
+    out << "sizeOf _ = 4" << std::endl;
+    indent(4);
+    out << "alignment _ = 4" << std::endl;
+    indent(4);
+    out << "peek p = toEnum . fromIntegral <$> (peek (castPtr p) :: IO Int32)"
+        << std::endl;
+    indent(4);
+    out << "poke p v = poke (castPtr p) (fromIntegral (fromEnum v) :: Int32)"
+        << std::endl;
+
+    out << std::endl;
+    out << "instance Anyable " << name << " where" << std::endl;
+    indent(4);
+    out << "toAny v = AEnumOf " << typeName << " (fromIntegral (fromEnum v))"
+        << std::endl;
+    indent(4);
+    out << "fromAny (AEnum _ v) = toEnum (fromIntegral v)" << std::endl;
+    indent(4);
+    out << "fromAny (AEnumOf _ v) = toEnum (fromIntegral v)" << std::endl;
+    indent(4);
+    out << "fromAny _ = error \"cannot extract to " << e->type << "\""
+        << std::endl;
+}
+
+void HsWriter::writeConstantGroupEntity () {
+    rtl::Reference< unoidl::ConstantGroupEntity > ent (
+            static_cast< unoidl::ConstantGroupEntity * >(entity->unoidl.get()));
+    vector< unoidl::ConstantGroupEntity::Member > members (ent->getMembers());
+    OUString prefix (decapitalize(entity->getName()));
+
+    for (vector< unoidl::ConstantGroupEntity::Member >::const_iterator
+            m(members.begin()) ; m != members.end() ; ++m)
+    {
+        OUString hsName (prefix + "_" + m->name);
+        OUString hsType;
+        OUString value;
+        switch (m->value.type) {
+            case unoidl::ConstantValue::TYPE_BOOLEAN:
+                hsType = "Bool";
+                value = m->value.booleanValue ? OUString("True")
+                    : OUString("False");
+                break;
+            case unoidl::ConstantValue::TYPE_BYTE:
+                hsType = "Word8";
+                value = OUString::number(
+                        static_cast< sal_uInt8 >(m->value.byteValue));
+                break;
+            case unoidl::ConstantValue::TYPE_SHORT:
+                hsType = "Int16";
+                value = OUString::number(m->value.shortValue);
+                break;
+            case unoidl::ConstantValue::TYPE_UNSIGNED_SHORT:
+                hsType = "Word16";
+                value = OUString::number(m->value.unsignedShortValue);
+                break;
+            case unoidl::ConstantValue::TYPE_LONG:
+                hsType = "Int32";
+                value = OUString::number(m->value.longValue);
+                break;
+            case unoidl::ConstantValue::TYPE_UNSIGNED_LONG:
+                hsType = "Word32";
+                value = OUString::number(m->value.unsignedLongValue);
+                break;
+            case unoidl::ConstantValue::TYPE_HYPER:
+                hsType = "Int64";
+                value = OUString::number(m->value.hyperValue);
+                break;
+            case unoidl::ConstantValue::TYPE_UNSIGNED_HYPER:
+                hsType = "Word64";
+                value = OUString::number(m->value.unsignedHyperValue);
+                break;
+            case unoidl::ConstantValue::TYPE_FLOAT:
+                hsType = "Float";
+                value = OUString::number(m->value.floatValue);
+                break;
+            case unoidl::ConstantValue::TYPE_DOUBLE:
+                hsType = "Double";
+                value = OUString::number(m->value.doubleValue);
+                break;
+        }
+        out << std::endl;
+        out << "{-# INLINE " << hsName << " #-}" << std::endl;
+        out << hsName << " :: " << hsType << std::endl;
+        out << hsName << " = " << value << std::endl;
+    }
+}
+
 set< OUString > HsWriter::plainStructTypeEntityDependencies () {
     set< OUString > deps;
     deps.insert(entity->getModule().getNameCapitalized());
@@ -417,6 +998,12 @@ set< OUString > HsWriter::interfaceTypeEntityDependencies () {
             static_cast<unoidl::InterfaceTypeEntity *>(entity->unoidl.get()));
     vector< unoidl::InterfaceTypeEntity::Method > members =
         ent->getDirectMethods();
+    // dependencies from attributes
+    vector< unoidl::InterfaceTypeEntity::Attribute > attributes (
+            ent->getDirectAttributes());
+    for (vector<unoidl::InterfaceTypeEntity::Attribute>::const_iterator
+            a(attributes.begin()) ; a != attributes.end() ; ++a)
+        members.push_back(attributeGetter(*a));
     for (vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
             m(members.begin()) ; m != members.end() ; ++m)
     {
@@ -426,7 +1013,7 @@ set< OUString > HsWriter::interfaceTypeEntityDependencies () {
             if (isSequenceType(type))
                 type = type.copy(2);
             if (!isPrimitiveType(type) && type != "any") {
-                Module dep (type);
+                Module const & dep (entities.getPath(type));
                 deps.insert(dep.getParent().getNameCapitalized());
                 //deps.insert(dep.getNameCapitalized());
             }
@@ -440,7 +1027,7 @@ set< OUString > HsWriter::interfaceTypeEntityDependencies () {
             if (isSequenceType(type))
                 type = type.copy(2);
             if (!isPrimitiveType(type) && type != "any") {
-                Module dep (type);
+                Module const & dep (entities.getPath(type));
                 deps.insert(dep.getParent().getNameCapitalized());
                 //deps.insert(dep.getNameCapitalized());
             }
@@ -453,18 +1040,79 @@ set< OUString > HsWriter::singleInterfaceBasedServiceEntityDependencies () {
     set< OUString > deps;
     rtl::Reference<unoidl::SingleInterfaceBasedServiceEntity> ent (
             static_cast<unoidl::SingleInterfaceBasedServiceEntity *>(entity->unoidl.get()));
-    deps.insert(Module(ent->getBase()).getParent().getNameCapitalized());
-    deps.insert(Module(ent->getBase()).getNameCapitalized());
+    deps.insert(entities.getPath(ent->getBase()).getParent().getNameCapitalized());
+    deps.insert(entities.getPath(ent->getBase()).getNameCapitalized());
     deps.insert("Com.Sun.Star.Uno");
     return deps;
 }
 
+OUString HsWriter::propertyType (OUString const & type) {
+    // typedefs such as com.sun.star.util.Color are accessed as their types
+    OUString resolved (entities.resolveTypedef(type));
+    // types with Anyable instances; toHsType has no unsigned types and reads
+    // char as a byte
+    if (resolved == "byte") return OUString("Word8");
+    if (resolved == "char") return OUString("Char");
+    if (resolved == "unsigned short") return OUString("Word16");
+    if (resolved == "unsigned long") return OUString("Word32");
+    if (resolved == "unsigned hyper") return OUString("Word64");
+    if (resolved == "boolean" || resolved == "short" || resolved == "long"
+            || resolved == "hyper" || resolved == "float"
+            || resolved == "double" || resolved == "string"
+            || resolved == "any")
+        return toHsType(entities, resolved);
+    if (entities.isInterface(resolved))
+        return toHsType(entities, resolved);
+    if (entities.isEnum(resolved))
+        return entities.getPath(resolved).getNameCapitalized();
+    return OUString();
+}
+
+// Only the stubs of interface members may be imported as interruptible.
+bool HsWriter::hasInterruptibleImports () {
+    if (!entity->unoidl.is()
+            || entity->unoidl->getSort() != unoidl::Entity::SORT_INTERFACE_TYPE)
+        return false;
+    rtl::Reference<unoidl::InterfaceTypeEntity> ent (
+            static_cast<unoidl::InterfaceTypeEntity *>(entity->unoidl.get()));
+    vector< unoidl::InterfaceTypeEntity::Method > methods (
+            ent->getDirectMethods());
+    for (vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
+            m(methods.begin()) ; m != methods.end() ; ++m)
+        if (ffiSafety(entity->type, m->name) == FFI_INTERRUPTIBLE)
+            return true;
+    vector< unoidl::InterfaceTypeEntity::Attribute > attributes (
+            ent->getDirectAttributes());
+    for (vector<unoidl::InterfaceTypeEntity::Attribute>::const_iterator
+            a(attributes.begin()) ; a != attributes.end() ; ++a)
+        if (ffiSafety(entity->type, a->name) == FFI_INTERRUPTIBLE)
+            return true;
+    return false;
+}
+
+set< OUString > HsWriter::accumulationBasedServiceEntityDependencies () {
+    set< OUString > deps;
+    rtl::Reference<unoidl::AccumulationBasedServiceEntity> ent (
+            static_cast<unoidl::AccumulationBasedServiceEntity *>(entity->unoidl.get()));
+    vector< unoidl::AccumulationBasedServiceEntity::Property > properties (
+            ent->getDirectProperties());
+    for (vector<unoidl::AccumulationBasedServiceEntity::Property>::const_iterator
+            p(properties.begin()) ; p != properties.end() ; ++p)
+    {
+        // interfaces and enums of the accessors
+        OUString type (entities.resolveTypedef(p->type));
+        if (!isSimpleType(type) && !propertyType(type).isEmpty())
+            deps.insert(entities.getPath(type).getParent().getNameCapitalized());
+    }
+    return deps;
+}
+
 set< OUString > HsWriter::interfaceBasedSingletonEntityDependencies () {
     set< OUString > deps;
     rtl::Reference<unoidl::InterfaceBasedSingletonEntity> ent (
             static_cast<unoidl::InterfaceBasedSingletonEntity *>(entity->unoidl.get()));
-    deps.insert(Module(ent->getBase()).getParent().getNameCapitalized());
-    deps.insert(Module(ent->getBase()).getNameCapitalized());
+    deps.insert(entities.getPath(ent->getBase()).getParent().getNameCapitalized());
+    deps.insert(entities.getPath(ent->getBase()).getNameCapitalized());
     deps.insert("Com.Sun.Star.Uno");
     return deps;
 }
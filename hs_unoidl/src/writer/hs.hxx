@@ -14,6 +14,7 @@
 
 #include "entity.hxx"
 #include "file.hxx"
+#include "options.hxx"
 #include "writer/utils.hxx"
 #include "writer/writer.hxx"
 
@@ -22,13 +23,14 @@ class HsWriter : public Writer {
         HsWriter(rtl::OUString const & fileurl, EntityRef const & entity)
             : Writer(fileurl, entity) {};
         HsWriter(rtl::OUString const & fileurl, EntityRef const & entity,
-                EntityList const & entities)
+                EntityTable const & entities)
             : Writer(fileurl, entity, entities) {};
         // generic writer methods
         void writeOpening (std::set< rtl::OUString > const & deps
                 = std::set< rtl::OUString >());
         void writeForeignImport (rtl::OUString & cfname, rtl::OUString & fname,
-                std::vector< rtl::OUString > & params, rtl::OUString & rtype);
+                std::vector< rtl::OUString > & params, rtl::OUString & rtype,
+                FfiSafety safety = FFI_SAFE);
         //void writeFunctionType (std::vector< OUString > classes,
         //        rtl::OUString & fname, std::vector< Parameter > & params,
         //        rtl::OUString & rtype, bool io = true);
@@ -38,6 +40,16 @@ class HsWriter : public Writer {
                 bool io = true);
         void writeFunctionLHS (rtl::OUString & fname,
                 std::vector< Parameter > & params);
+        void writeMethod (rtl::OUString & hsMethodName,
+                rtl::OUString & hsForeignMethodName,
+                unoidl::InterfaceTypeEntity::Method const & method,
+                bool lazyResult = false);
+        void writeMemberForeignImport (rtl::OUString const & suffix,
+                unoidl::InterfaceTypeEntity::Method const & method);
+        void writeAsyncFunction (rtl::OUString & fname,
+                rtl::OUString & syncfname,
+                std::vector< rtl::OUString > & classes,
+                std::vector< Parameter > & params, rtl::OUString & rtype);
         // UNO Entities
         // - plain struct type
         void writePlainStructTypeEntity ();
@@ -47,14 +59,34 @@ class HsWriter : public Writer {
         void writeExceptionTypeEntity ();
         // - single-interface-based service
         void writeSingleInterfaceBasedServiceEntity ();
+        // - accumulation-based service
+        void writeAccumulationBasedServiceEntity ();
         // - interface-based singleton
         void writeInterfaceBasedSingletonEntity ();
+        // - constant group
+        void writeConstantGroupEntity ();
         // UNO Entity module
-        void writeModule ();
+        void writeModule (std::vector< sal_Int32 > const & members);
+        void writeFlatStruct (EntityRef const & flat);
+        void writeEnum (EntityRef const & e);
         // auxiliary methods
+        rtl::OUString sequenceArgumentElementType (rtl::OUString const & type);
+        rtl::OUString methodResultType (rtl::OUString const & type,
+                bool lazyResult = false);
+        void methodParameters (
+                unoidl::InterfaceTypeEntity::Method const & method,
+                std::vector< Parameter > & methodParams,
+                std::vector< rtl::OUString > & classes);
+        rtl::OUString propertyType (rtl::OUString const & type);
+        bool hasInterruptibleImports ();
+        unoidl::InterfaceTypeEntity::Method attributeGetter (
+                unoidl::InterfaceTypeEntity::Attribute const & attribute);
+        unoidl::InterfaceTypeEntity::Method attributeSetter (
+                unoidl::InterfaceTypeEntity::Attribute const & attribute);
         std::set< rtl::OUString > plainStructTypeEntityDependencies ();
         std::set< rtl::OUString > interfaceTypeEntityDependencies ();
         std::set< rtl::OUString > singleInterfaceBasedServiceEntityDependencies ();
+        std::set< rtl::OUString > accumulationBasedServiceEntityDependencies ();
         std::set< rtl::OUString > interfaceBasedSingletonEntityDependencies ();
 };
 
@@ -22,7 +22,7 @@ OUString entityHeaderGuardName (EntityRef const & entity)
 {
     OUStringBuffer buf;
     buf.append(headerGuardPrefix);
-    buf.append(Module(entity->type).asHeaderGuard());
+    buf.append(entity->path.asHeaderGuard());
     buf.append(headerGuardSuffix);
     return buf.makeStringAndClear();
 }
@@ -44,7 +44,7 @@ void HxxWriter::writeClosing () {
 }
 
 void HxxWriter::writePlainStructTypeEntity () {
-    Module entityModule = Module(entity->type);
+    Module const & entityModule (entity->path);
     OUString name = entity->getName();
     OUString entityNameCapitalized (capitalize(name));
     OUString fqn = entity->type;
@@ -54,6 +54,10 @@ void HxxWriter::writePlainStructTypeEntity () {
 
     out << "#include \"" << entityModule.asPath() << ".hpp\"" << std::endl;
 
+    // flat structs are read and written in place by Haskell code
+    if (entities.isFlatStruct(entity->type))
+        return;
+
     vector< unoidl::PlainStructTypeEntity::Member > members = ent->getDirectMembers();
     vector< Parameter > getterParams;
     getterParams.push_back({ "hsuno " + fqnCpp + " *", "o" + name }); // FIXME hardcoded type
@@ -92,7 +96,7 @@ void HxxWriter::writePlainStructTypeEntity () {
 }
 
 void HxxWriter::writeInterfaceTypeEntity () {
-    Module entityModule = Module(entity->type);
+    Module const & entityModule (entity->path);
     OUString fqn = entity->type;
     rtl::Reference<unoidl::InterfaceTypeEntity> ent (
             static_cast<unoidl::InterfaceTypeEntity *>(entity->unoidl.get()));
@@ -101,38 +105,68 @@ void HxxWriter::writeInterfaceTypeEntity () {
 
     vector< unoidl::InterfaceTypeEntity::Method > methods = ent->getDirectMethods();
 
+    // attributes, as their getter and setter methods
+    vector< unoidl::InterfaceTypeEntity::Attribute > attributes (
+            ent->getDirectAttributes());
+    for (vector< unoidl::InterfaceTypeEntity::Attribute >::const_iterator
+            a(attributes.begin()) ; a != attributes.end() ; ++a)
+    {
+        vector< unoidl::InterfaceTypeEntity::Method::Parameter > noParams;
+        writeMemberDeclaration(functionPrefix + toFunctionPrefix(fqn) + "_get_"
+                + a->name, unoidl::InterfaceTypeEntity::Method(a->name, a->type,
+                    noParams, a->getExceptions, vector< OUString >()));
+        if (a->readOnly)
+            continue;
+        vector< unoidl::InterfaceTypeEntity::Method::Parameter > params;
+        params.push_back(unoidl::InterfaceTypeEntity::Method::Parameter(
+                    a->name, a->type, unoidl::InterfaceTypeEntity::Method
+                    ::Parameter::DIRECTION_IN));
+        writeMemberDeclaration(functionPrefix + toFunctionPrefix(fqn) + "_set_"
+                + a->name, unoidl::InterfaceTypeEntity::Method(a->name, "void",
+                    params, a->setExceptions, vector< OUString >()));
+    }
+
     for (std::vector<unoidl::InterfaceTypeEntity::Method>::const_iterator
             j(methods.begin()); j != methods.end(); ++j)
+        writeMemberDeclaration(functionPrefix + toFunctionPrefix(fqn) + "_"
+                + j->name, *j);
+}
+
+void HxxWriter::writeMemberDeclaration (OUString const & cMethodName,
+        unoidl::InterfaceTypeEntity::Method const & method)
+{
+    std::vector< Parameter > params;
+    params.push_back({ OUString("hsuno_interface"), OUString("iface") });
+    params.push_back({ OUString("hsuno_exception_ptr"), OUString("exception") });
+    for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
+            k(method.parameters.begin()) ; k != method.parameters.end() ; ++k)
     {
-        OUString cMethodName (functionPrefix + toFunctionPrefix(fqn) + "_"
-                + j->name);
-
-        std::vector< Parameter > params;
-        params.push_back({ OUString("hsuno_interface"), OUString("iface") });
-        params.push_back({ OUString("hsuno_exception_ptr"), OUString("exception") });
-        for (std::vector<unoidl::InterfaceTypeEntity::Method::Parameter>::const_iterator
-                k(j->parameters.begin()) ; k != j->parameters.end() ; ++k)
+        if (isStringType(k->type))
+            params.push_back({ OUString("hsuno rtl_uString *"), k->name });
+        else
             params.push_back({ k->type, k->name });
-
-        out << std::endl;
-        assert(hasEntityList); // FIXME temporary
-        bool isInterface = false;
-        {
-            EntityList::const_iterator entIt = entities.find(j->returnType);
-            if (entIt != entities.end() && entIt->second->isInterface())
-                isInterface = true;
-        }
-        out << std::endl;
-        out << cFunctionDeclaration(entities, cMethodName, params,
-                isInterface ? "hsuno_interface" : j->returnType) << ";" << std::endl;
     }
+
+    out << std::endl;
+    assert(hasEntityList); // FIXME temporary
+    bool isInterface = entities.isInterface(method.returnType);
+    bool isStorable = isStorableType(method.returnType);
+    if (isStorable)
+        params.push_back({ method.returnType, OUString("result") });
+    OUString cReturnType (isInterface ? OUString("hsuno_interface")
+            : isStringType(method.returnType) ? OUString("hsuno rtl_uString *")
+            : isStorable ? OUString("void")
+            : method.returnType);
+    out << std::endl;
+    out << cFunctionDeclaration(entities, cMethodName, params, cReturnType)
+        << ";" << std::endl;
 }
 
 void HxxWriter::writeSingleInterfaceBasedServiceEntity () {
-    Module entityModule = Module(entity->type);
+    Module const & entityModule (entity->path);
     rtl::Reference<unoidl::SingleInterfaceBasedServiceEntity> ent (
             static_cast<unoidl::SingleInterfaceBasedServiceEntity *>(entity->unoidl.get()));
-    Module baseModule(ent->getBase());
+    Module const & baseModule (entities.getPath(ent->getBase()));
     OUString baseFqn (baseModule.asNamespace());
 
     out << "#include \"" << entityModule.asPath() << ".hpp\"" << std::endl;
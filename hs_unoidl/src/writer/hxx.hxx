@@ -22,12 +22,14 @@ class HxxWriter : public Writer {
         HxxWriter(rtl::OUString const & fileurl, EntityRef const & entity)
             : Writer(fileurl, entity) {};
         HxxWriter(rtl::OUString const & fileurl, EntityRef const & entity,
-                EntityList const & entities)
+                EntityTable const & entities)
             : Writer(fileurl, entity, entities) {};
         void writeOpening ();
         void writeClosing ();
         void writePlainStructTypeEntity ();
         void writeInterfaceTypeEntity ();
+        void writeMemberDeclaration (rtl::OUString const & cMethodName,
+                unoidl::InterfaceTypeEntity::Method const & method);
         void writeSingleInterfaceBasedServiceEntity ();
 };
 
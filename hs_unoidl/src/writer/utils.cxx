@@ -16,7 +16,7 @@ using rtl::OUString;
 using rtl::OUStringBuffer;
 using std::vector;
 
-OUString cFunctionDeclaration(EntityList const & entities,
+OUString cFunctionDeclaration(EntityTable const & entities,
         OUString name, std::vector< Parameter > params,
         OUString type)
 {
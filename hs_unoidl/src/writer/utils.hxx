@@ -14,13 +14,14 @@
 #include <vector>
 
 #include "../entity.hxx"
+#include "../entitytable.hxx"
 
 typedef struct _Parameter {
     rtl::OUString type;
     rtl::OUString name;
 } Parameter;
 
-rtl::OUString cFunctionDeclaration(EntityList const & entities,
+rtl::OUString cFunctionDeclaration(EntityTable const & entities,
         rtl::OUString name, std::vector< Parameter > params,
         rtl::OUString type);
 
@@ -13,24 +13,30 @@
 #include "rtl/ustring.hxx"
 
 #include "entity.hxx"
+#include "entitytable.hxx"
 #include "file.hxx"
 #include "writer/utils.hxx"
 
 class Writer {
     public:
         Writer(rtl::OUString const & fileurl, EntityRef const & entity)
-            : out(fileurl), entity(entity), hasEntityList(false) {};
+            : out(fileurl), entity(entity), entities(EntityTable::empty()),
+            hasEntityList(false) {};
         Writer(rtl::OUString const & fileurl, EntityRef const & entity,
-                EntityList const & entities)
+                EntityTable const & entities)
             : out(fileurl), entity(entity), entities(entities),
             hasEntityList(true) {};
     protected:
         File out;
         const EntityRef entity;
-        const EntityList entities;
+        EntityTable const & entities;
         bool hasEntityList;
 
         void indent (int n) { ::indent(out, n); };
+
+        bool isStorableType (rtl::OUString const & type) const {
+            return entities.isStorable(type);
+        };
 };
 
 #endif /* HSUNOIDL_WRITER_WRITER_HXX */